@@ -0,0 +1,208 @@
+#include "ai.h"
+
+#include <cmath>
+
+#include "collision_simd.h"
+
+template <typename Rules>
+void ChaseBall(Ball const &ball, Paddle const &paddle, bool &up, bool &down, Rules const &rules)
+{
+    float ballCenter = ball.position.y + rules.ballHeight / 2.0f;
+    float paddleCenter = paddle.position.y + rules.paddleHeight / 2.0f;
+
+    up = ballCenter < paddleCenter - rules.paddleHeight / 4.0f;
+    down = ballCenter > paddleCenter + rules.paddleHeight / 4.0f;
+}
+
+template void ChaseBall<StandardRules>(Ball const &, Paddle const &, bool &, bool &, StandardRules const &);
+template void ChaseBall<RuntimeRules>(Ball const &, Paddle const &, bool &, bool &, RuntimeRules const &);
+
+template <typename Rules>
+Intercept SolveIntercept(float ballX, float ballY, float ballVX, float ballVY, float paddleX, Rules const &rules)
+{
+    // The ball's left edge when it touches the face turned towards it
+    float plane = ballVX > 0.0f ? paddleX - rules.ballWidth : paddleX + rules.paddleWidth;
+    float time = (plane - ballX) / ballVX;
+
+    if (ballVX == 0.0f || !(time >= 0.0f))
+    {
+        return {ballY, -1.0f};
+    }
+
+    // Unfold the bounces: y keeps going, then folds back into the field
+    float range = rules.height - rules.ballHeight;
+    float period = 2.0f * range;
+    float y = ballY + ballVY * time;
+    float folded = y - floorf(y / period) * period;
+
+    return {folded > range ? period - folded : folded, time};
+}
+
+template <typename Rules>
+void InterceptBall(Ball const &ball, Paddle const &paddle, bool &up, bool &down, Rules const &rules)
+{
+    Intercept intercept = SolveIntercept(ball.position.x, ball.position.y, ball.velocity.x, ball.velocity.y,
+                                         paddle.position.x, rules);
+
+    float target = intercept.time >= 0.0f ? intercept.y + rules.ballHeight / 2.0f : rules.height / 2.0f;
+    float paddleCenter = paddle.position.y + rules.paddleHeight / 2.0f;
+
+    up = target < paddleCenter - rules.paddleHeight / 4.0f;
+    down = target > paddleCenter + rules.paddleHeight / 4.0f;
+}
+
+template Intercept SolveIntercept<StandardRules>(float, float, float, float, float, StandardRules const &);
+template Intercept SolveIntercept<RuntimeRules>(float, float, float, float, float, RuntimeRules const &);
+template void InterceptBall<StandardRules>(Ball const &, Paddle const &, bool &, bool &, StandardRules const &);
+template void InterceptBall<RuntimeRules>(Ball const &, Paddle const &, bool &, bool &, RuntimeRules const &);
+
+void SolveInterceptsScalar(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                           float paddleX, int count, Intercept *out)
+{
+    for (int i = 0; i < count; i++)
+    {
+        out[i] = SolveIntercept(ballX[i], ballY[i], ballVX[i], ballVY[i], paddleX);
+    }
+}
+
+#ifdef PONG_X86
+
+static_assert(sizeof(Intercept) == 2 * sizeof(float), "Intercept must be {float y, float time}");
+
+static const float Range = StandardRules::height - StandardRules::ballHeight;
+static const float Period = 2.0f * Range;
+
+// floorf for every float. Below 2^23 truncate and step down if that went
+// up (keeping the sign, for -0); from there on every float is a whole
+// number already (and NaN stays).
+static inline __m128 Floor(__m128 value)
+{
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+    __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+    floored = _mm_or_ps(floored, _mm_and_ps(value, _mm_set1_ps(-0.0f)));
+    __m128 small = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), value), _mm_set1_ps(8388608.0f));
+    return _mm_or_ps(_mm_and_ps(small, floored), _mm_andnot_ps(small, value));
+}
+
+void SolveInterceptsSSE2(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                         float paddleX, int count, Intercept *out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 range = _mm_set1_ps(Range);
+    const __m128 period = _mm_set1_ps(Period);
+    const __m128 rightPlane = _mm_set1_ps(paddleX - StandardRules::ballWidth);
+    const __m128 leftPlane = _mm_set1_ps(paddleX + StandardRules::paddleWidth);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(ballX + i);
+        __m128 y = _mm_loadu_ps(ballY + i);
+        __m128 vx = _mm_loadu_ps(ballVX + i);
+        __m128 vy = _mm_loadu_ps(ballVY + i);
+
+        __m128 movingRight = _mm_cmpgt_ps(vx, zero);
+        __m128 plane = _mm_or_ps(_mm_and_ps(movingRight, rightPlane), _mm_andnot_ps(movingRight, leftPlane));
+        __m128 time = _mm_div_ps(_mm_sub_ps(plane, x), vx);
+        __m128 valid = _mm_and_ps(_mm_cmpneq_ps(vx, zero), _mm_cmpge_ps(time, zero));
+
+        __m128 unfolded = _mm_add_ps(y, _mm_mul_ps(vy, time));
+        __m128 folded = _mm_sub_ps(unfolded, _mm_mul_ps(Floor(_mm_div_ps(unfolded, period)), period));
+        __m128 high = _mm_cmpgt_ps(folded, range);
+        folded = _mm_or_ps(_mm_and_ps(high, _mm_sub_ps(period, folded)), _mm_andnot_ps(high, folded));
+
+        __m128 outY = _mm_or_ps(_mm_and_ps(valid, folded), _mm_andnot_ps(valid, y));
+        __m128 outTime = _mm_or_ps(_mm_and_ps(valid, time), _mm_andnot_ps(valid, _mm_set1_ps(-1.0f)));
+
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i), _mm_unpacklo_ps(outY, outTime));
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i + 2), _mm_unpackhi_ps(outY, outTime));
+    }
+
+    SolveInterceptsScalar(ballX + i, ballY + i, ballVX + i, ballVY + i, paddleX, count - i, out + i);
+}
+
+__attribute__((target("avx2"))) void SolveInterceptsAVX2(float const *ballX, float const *ballY, float const *ballVX,
+                                                         float const *ballVY, float paddleX, int count, Intercept *out)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 range = _mm256_set1_ps(Range);
+    const __m256 period = _mm256_set1_ps(Period);
+    const __m256 rightPlane = _mm256_set1_ps(paddleX - StandardRules::ballWidth);
+    const __m256 leftPlane = _mm256_set1_ps(paddleX + StandardRules::paddleWidth);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(ballX + i);
+        __m256 y = _mm256_loadu_ps(ballY + i);
+        __m256 vx = _mm256_loadu_ps(ballVX + i);
+        __m256 vy = _mm256_loadu_ps(ballVY + i);
+
+        __m256 plane = _mm256_blendv_ps(leftPlane, rightPlane, _mm256_cmp_ps(vx, zero, _CMP_GT_OQ));
+        __m256 time = _mm256_div_ps(_mm256_sub_ps(plane, x), vx);
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(vx, zero, _CMP_NEQ_UQ), _mm256_cmp_ps(time, zero, _CMP_GE_OQ));
+
+        __m256 unfolded = _mm256_add_ps(y, _mm256_mul_ps(vy, time));
+        __m256 whole = _mm256_floor_ps(_mm256_div_ps(unfolded, period));
+        __m256 folded = _mm256_sub_ps(unfolded, _mm256_mul_ps(whole, period));
+        folded = _mm256_blendv_ps(folded, _mm256_sub_ps(period, folded), _mm256_cmp_ps(folded, range, _CMP_GT_OQ));
+
+        __m256 outY = _mm256_blendv_ps(y, folded, valid);
+        __m256 outTime = _mm256_blendv_ps(_mm256_set1_ps(-1.0f), time, valid);
+
+        // Interleave into (y, time) pairs, like the collision kernels do
+        __m256 lo = _mm256_unpacklo_ps(outY, outTime);
+        __m256 hi = _mm256_unpackhi_ps(outY, outTime);
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i + 4), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+    SolveInterceptsSSE2(ballX + i, ballY + i, ballVX + i, ballVY + i, paddleX, count - i, out + i);
+}
+
+#else
+
+void SolveInterceptsSSE2(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                         float paddleX, int count, Intercept *out)
+{
+    SolveInterceptsScalar(ballX, ballY, ballVX, ballVY, paddleX, count, out);
+}
+
+void SolveInterceptsAVX2(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                         float paddleX, int count, Intercept *out)
+{
+    SolveInterceptsScalar(ballX, ballY, ballVX, ballVY, paddleX, count, out);
+}
+
+#endif
+
+void SolveIntercepts(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                     float paddleX, int count, Intercept *out)
+{
+    if (HasAVX2())
+    {
+        SolveInterceptsAVX2(ballX, ballY, ballVX, ballVY, paddleX, count, out);
+    }
+    else
+    {
+        SolveInterceptsSSE2(ballX, ballY, ballVX, ballVY, paddleX, count, out);
+    }
+}
+
+void ScriptedInput::Next(bool buttons[4])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (holdTicks[i] == 0)
+        {
+            held[i] = (rng.NextU32() % 3) == 0;
+            holdTicks[i] = 1 + rng.NextU32() % 60;
+        }
+        --holdTicks[i];
+        buttons[i] = held[i];
+    }
+
+    // Up wins if a script holds both directions
+    buttons[Buttons::PaddleOneDown] = buttons[Buttons::PaddleOneDown] && !buttons[Buttons::PaddleOneUP];
+    buttons[Buttons::PaddleTwoDown] = buttons[Buttons::PaddleTwoDown] && !buttons[Buttons::PaddleTwoUp];
+}
@@ -0,0 +1,56 @@
+// Computer-controlled inputs for matches nobody is playing
+#pragma once
+
+#include "pong.h"
+
+// Move a paddle towards the ball's height, with a small dead zone so it
+// doesn't jitter when it's already lined up.
+template <typename Rules = StandardRules>
+void ChaseBall(Ball const &ball, Paddle const &paddle, bool &up, bool &down, Rules const &rules = Rules());
+
+// Where and when a ball gets to a paddle's face
+struct Intercept
+{
+    float y;    // Top of the ball at that moment
+    float time; // In ms from now, negative if the ball never gets there
+};
+
+// Closed form, no stepping: the ball flies straight to the paddle's face,
+// and the top/bottom bounces (CheckWallCollisions snapping it back onto the
+// wall) fold its unbounded y into [0, height - ballHeight] as a triangle
+// wave. Bounces off anything else on the way aren't taken into account.
+template <typename Rules = StandardRules>
+Intercept SolveIntercept(float ballX, float ballY, float ballVX, float ballVY, float paddleX,
+                         Rules const &rules = Rules());
+
+// The same for count balls (structure of arrays) against a paddle at
+// paddleX, standard rules, 4 or 8 at a time. Lane i is exactly what
+// SolveIntercept returns for ball i.
+void SolveIntercepts(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                     float paddleX, int count, Intercept *out);
+
+void SolveInterceptsScalar(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                           float paddleX, int count, Intercept *out);
+void SolveInterceptsSSE2(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                         float paddleX, int count, Intercept *out);
+void SolveInterceptsAVX2(float const *ballX, float const *ballY, float const *ballVX, float const *ballVY,
+                         float paddleX, int count, Intercept *out);
+
+// Move a paddle to where the ball is going to arrive, and back towards
+// the middle while it's heading the other way. Same dead zone as ChaseBall.
+template <typename Rules = StandardRules>
+void InterceptBall(Ball const &ball, Paddle const &paddle, bool &up, bool &down, Rules const &rules = Rules());
+
+// Scripted input: every button is held or released for a random stretch
+class ScriptedInput
+{
+public:
+    explicit ScriptedInput(uint64_t seed = 1) : rng(seed) {}
+
+    void Next(bool buttons[4]);
+
+private:
+    Rng rng;
+    bool held[4] = {};
+    int holdTicks[4] = {};
+};
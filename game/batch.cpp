@@ -0,0 +1,186 @@
+#include "batch.h"
+
+#include <new>
+
+#include "collision_simd.h"
+#include "pong.h"
+
+static_assert(BatchMatches::Paddle_Two_X == WIDTH - 50.0f, "Paddle two must match Match's layout");
+
+BatchMatches::BatchMatches(int count, uint64_t seed) : count(count)
+{
+    stride = (static_cast<size_t>(count) + Batch_Lane_Padding - 1) / Batch_Lane_Padding * Batch_Lane_Padding;
+
+    // One block for every field, each field starting on a cache line. The
+    // 64-bit Rng states take two float slots each.
+    const int fields = 10;
+    storage = ::operator new(fields * stride * sizeof(float), std::align_val_t(Batch_Alignment));
+
+    float *base = static_cast<float *>(storage);
+    ballX = base + 0 * stride;
+    ballY = base + 1 * stride;
+    ballVX = base + 2 * stride;
+    ballVY = base + 3 * stride;
+    paddleOneY = base + 4 * stride;
+    paddleTwoY = base + 5 * stride;
+    playerOneScore = reinterpret_cast<int32_t *>(base + 6 * stride);
+    playerTwoScore = reinterpret_cast<int32_t *>(base + 7 * stride);
+    rngState = reinterpret_cast<uint64_t *>(base + 8 * stride);
+
+    // Padding lanes are never stepped, but SIMD loads can touch them so
+    // give them sane values too
+    for (size_t i = 0; i < stride; i++)
+    {
+        rngState[i] = SeedFor(seed, i);
+        Reset(static_cast<int>(i));
+    }
+}
+
+BatchMatches::~BatchMatches()
+{
+    ::operator delete(storage, std::align_val_t(Batch_Alignment));
+}
+
+void BatchMatches::Reset(int i)
+{
+    Match match;
+
+    ballX[i] = match.ball.position.x;
+    ballY[i] = match.ball.position.y;
+    ballVX[i] = match.ball.velocity.x;
+    ballVY[i] = match.ball.velocity.y;
+    paddleOneY[i] = match.paddle1.position.y;
+    paddleTwoY[i] = match.paddle2.position.y;
+    playerOneScore[i] = 0;
+    playerTwoScore[i] = 0;
+}
+
+// Held buttons to paddle speed, same priority as Match::SetButtons
+static inline float PaddleVelocity(uint8_t mask, int up, int down)
+{
+    if (mask & (1 << up))
+    {
+        return -Paddle_Speed;
+    }
+    if (mask & (1 << down))
+    {
+        return Paddle_Speed;
+    }
+    return 0.0f;
+}
+
+#ifdef PONG_VEC2_SIMD
+// The whole groups of 8 balls; returns how many lanes it did
+PONG_AVX_TARGET static int MoveBallsAVX(float *x, float *y, float const *vx, float const *vy, int count, float dt)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        Vec2x8 position = Vec2x8::Load(x + i, y + i);
+        position += Vec2x8::Load(vx + i, vy + i) * dt;
+        position.Store(x + i, y + i);
+    }
+    return i;
+}
+#endif
+
+void BatchMatches::Step(float dt, uint8_t const *buttons)
+{
+    const float paddleMax = HEIGHT - Paddle_Height;
+
+    // Paddles
+    for (int i = 0; i < count; i++)
+    {
+        float y1 = paddleOneY[i] + PaddleVelocity(buttons[i], Buttons::PaddleOneUP, Buttons::PaddleOneDown) * dt;
+        float y2 = paddleTwoY[i] + PaddleVelocity(buttons[i], Buttons::PaddleTwoUp, Buttons::PaddleTwoDown) * dt;
+
+        paddleOneY[i] = y1 < 0.0f ? 0.0f : (y1 > paddleMax ? paddleMax : y1);
+        paddleTwoY[i] = y2 < 0.0f ? 0.0f : (y2 > paddleMax ? paddleMax : y2);
+    }
+
+    // Ball, as many lanes at a time as the CPU takes
+    int i = 0;
+#ifdef PONG_VEC2_SIMD
+    if (HasAVX2())
+    {
+        i = MoveBallsAVX(ballX, ballY, ballVX, ballVY, count, dt);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        Vec2x4 position = Vec2x4::Load(ballX + i, ballY + i);
+        position += Vec2x4::Load(ballVX + i, ballVY + i) * dt;
+        position.Store(ballX + i, ballY + i);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        Vec2 position = Vec2(ballX[i], ballY[i]) + Vec2(ballVX[i], ballVY[i]) * dt;
+        ballX[i] = position.x;
+        ballY[i] = position.y;
+    }
+
+    // Collisions. The kernels test every lane against both paddles and the
+    // walls; the first hit in the same order as Match::Tick wins.
+    const int chunk = 256;
+    Contact paddleOne[chunk];
+    Contact paddleTwo[chunk];
+    Contact wall[chunk];
+
+    for (int start = 0; start < count; start += chunk)
+    {
+        int n = count - start < chunk ? count - start : chunk;
+
+        CheckPaddleCollisions(ballX + start, ballY + start, ballVX + start, Paddle_One_X, paddleOneY + start, n, paddleOne);
+        CheckPaddleCollisions(ballX + start, ballY + start, ballVX + start, Paddle_Two_X, paddleTwoY + start, n, paddleTwo);
+        CheckWallCollisionsBatch(ballX + start, ballY + start, n, wall);
+
+        for (int j = 0; j < n; j++)
+        {
+            int i = start + j;
+
+            Contact contact = paddleOne[j].type != CollisionType::None ? paddleOne[j] : paddleTwo[j];
+            if (contact.type != CollisionType::None)
+            {
+                // Same as Ball::CollisionWithPaddle
+                ballX[i] += contact.penetration;
+                ballVX[i] = -ballVX[i];
+
+                if (contact.type == CollisionType::Top)
+                {
+                    ballVY[i] = -0.75f * Ball_Speed;
+                }
+                else if (contact.type == CollisionType::Bottom)
+                {
+                    ballVY[i] = 0.75f * Ball_Speed;
+                }
+            }
+            else if (wall[j].type == CollisionType::Top || wall[j].type == CollisionType::Bottom)
+            {
+                ballY[i] += wall[j].penetration;
+                ballVY[i] = -ballVY[i];
+            }
+            else if (wall[j].type != CollisionType::None)
+            {
+                // A point was scored. Rare, so let Ball do the serve.
+                Ball ball(Vec2(ballX[i], ballY[i]), Vec2(ballVX[i], ballVY[i]));
+                Rng rng(rngState[i]);
+                ball.CollideWithWall(wall[j], rng);
+                rngState[i] = rng.state;
+
+                ballX[i] = ball.position.x;
+                ballY[i] = ball.position.y;
+                ballVX[i] = ball.velocity.x;
+                ballVY[i] = ball.velocity.y;
+
+                if (wall[j].type == CollisionType::Left)
+                {
+                    ++playerTwoScore[i];
+                }
+                else
+                {
+                    ++playerOneScore[i];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Structure-of-arrays engine for stepping thousands of independent matches
+// at once. Same rules as Match, but every field lives in its own contiguous
+// array so the per-tick loops stream through memory.
+//
+// Collisions use the discrete overlap tests (see collision_simd.h) rather
+// than Match's swept ones, so keep dt near the normal tick: a step longer
+// than the paddle is thick can let the ball through.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Field arrays are aligned to a cache line and padded to a whole number of
+// them, so SIMD code can always load full registers.
+const int Batch_Alignment = 64;
+const int Batch_Lane_Padding = Batch_Alignment / sizeof(float);
+
+class BatchMatches
+{
+public:
+    // Match i serves from its own Rng seeded with SeedFor(seed, i)
+    explicit BatchMatches(int count, uint64_t seed = 1);
+    ~BatchMatches();
+
+    BatchMatches(BatchMatches const &) = delete;
+    BatchMatches &operator=(BatchMatches const &) = delete;
+
+    int Count() const { return count; }
+
+    // Put match i back to the kick-off state with a zero score. Its Rng
+    // carries on where it was.
+    void Reset(int i);
+
+    // Advance every match by one tick. buttons holds one PackButtons mask
+    // per match.
+    void Step(float dt, uint8_t const *buttons);
+
+    // Position of the two paddles is fixed on x, like in Match
+    static constexpr float Paddle_One_X = 50.0f;
+    static constexpr float Paddle_Two_X = 1280.0f - 50.0f;
+
+    float *ballX;
+    float *ballY;
+    float *ballVX;
+    float *ballVY;
+    float *paddleOneY;
+    float *paddleTwoY;
+    int32_t *playerOneScore;
+    int32_t *playerTwoScore;
+    uint64_t *rngState;
+
+private:
+    int count;
+    size_t stride; // Padded element count of every array
+    void *storage;
+};
@@ -0,0 +1,313 @@
+#include "collision_simd.h"
+
+// The SIMD kernels write a type and a penetration per lane as one
+// interleaved pair, so Contact has to be exactly that.
+static_assert(sizeof(Contact) == 2 * sizeof(float), "Contact must be {int32 type, float penetration}");
+static_assert(sizeof(CollisionType) == sizeof(int), "CollisionType must be 32 bits");
+
+// Same constants the scalar code computes inline, evaluated the same way
+static const float Ball_Width_F = Ball_Width;
+static const float Ball_Height_F = Ball_Height;
+static const float Paddle_Width_F = Paddle_Width;
+static const float Paddle_Height_F = Paddle_Height;
+static const float Range_Upper = 2.0f * Paddle_Height / 3.0f;
+static const float Range_Middle = Paddle_Height / 3.0f;
+static const float Width_F = WIDTH;
+static const float Height_F = HEIGHT;
+
+void CheckPaddleCollisionsScalar(float const *ballX, float const *ballY, float const *ballVX,
+                                 float paddleX, float const *paddleY, int count, Contact *out)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Ball ball(Vec2(ballX[i], ballY[i]), Vec2(ballVX[i], 0.0f));
+        Paddle paddle(Vec2(paddleX, paddleY[i]), Vec2());
+        out[i] = chekcPaddleCollision(ball, paddle);
+    }
+}
+
+void CheckWallCollisionsScalar(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Ball ball(Vec2(ballX[i], ballY[i]), Vec2());
+        out[i] = CheckWallCollisions(ball);
+    }
+}
+
+#ifdef PONG_X86
+
+// Comparisons use the "not" forms (nge, nle) wherever the scalar code
+// early-outs on the opposite test, so NaNs end up in the same branch too.
+
+void CheckPaddleCollisionsSSE2(float const *ballX, float const *ballY, float const *ballVX,
+                               float paddleX, float const *paddleY, int count, Contact *out)
+{
+    const __m128 ballWidth = _mm_set1_ps(Ball_Width_F);
+    const __m128 ballHeight = _mm_set1_ps(Ball_Height_F);
+    const __m128 paddleHeight = _mm_set1_ps(Paddle_Height_F);
+    const __m128 rangeUpper = _mm_set1_ps(Range_Upper);
+    const __m128 rangeMiddle = _mm_set1_ps(Range_Middle);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 paddleLeft = _mm_set1_ps(paddleX);
+    const __m128 paddleRight = _mm_set1_ps(paddleX + Paddle_Width_F);
+    const __m128i typeTop = _mm_set1_epi32(static_cast<int>(CollisionType::Top));
+    const __m128i typeMiddle = _mm_set1_epi32(static_cast<int>(CollisionType::Middle));
+    const __m128i typeBottom = _mm_set1_epi32(static_cast<int>(CollisionType::Bottom));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 ballLeft = _mm_loadu_ps(ballX + i);
+        __m128 ballTop = _mm_loadu_ps(ballY + i);
+        __m128 velocityX = _mm_loadu_ps(ballVX + i);
+        __m128 paddleTop = _mm_loadu_ps(paddleY + i);
+
+        __m128 ballRight = _mm_add_ps(ballLeft, ballWidth);
+        __m128 ballBottom = _mm_add_ps(ballTop, ballHeight);
+        __m128 paddleBottom = _mm_add_ps(paddleTop, paddleHeight);
+
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpnge_ps(ballLeft, paddleRight),
+                                           _mm_cmpnle_ps(ballRight, paddleLeft)),
+                                _mm_and_ps(_mm_cmpnge_ps(ballTop, paddleBottom),
+                                           _mm_cmpnle_ps(ballBottom, paddleTop)));
+
+        // Left paddle when moving left, right paddle when moving right
+        __m128 movingLeft = _mm_cmplt_ps(velocityX, zero);
+        __m128 movingRight = _mm_cmpgt_ps(velocityX, zero);
+        __m128 penetration = _mm_or_ps(_mm_and_ps(movingLeft, _mm_sub_ps(paddleRight, ballLeft)),
+                                       _mm_and_ps(movingRight, _mm_sub_ps(paddleLeft, ballRight)));
+
+        __m128 paddleRangeUpper = _mm_sub_ps(paddleBottom, rangeUpper);
+        __m128 paddleRangeMiddle = _mm_sub_ps(paddleBottom, rangeMiddle);
+        __m128 top = _mm_and_ps(_mm_cmpgt_ps(ballBottom, paddleTop), _mm_cmplt_ps(ballBottom, paddleRangeUpper));
+        __m128 middle = _mm_and_ps(_mm_cmpgt_ps(ballBottom, paddleRangeUpper), _mm_cmplt_ps(ballBottom, paddleRangeMiddle));
+
+        // Bottom unless middle, unless top, and nothing at all without a hit
+        __m128i type = typeBottom;
+        type = _mm_or_si128(_mm_and_si128(_mm_castps_si128(middle), typeMiddle),
+                            _mm_andnot_si128(_mm_castps_si128(middle), type));
+        type = _mm_or_si128(_mm_and_si128(_mm_castps_si128(top), typeTop),
+                            _mm_andnot_si128(_mm_castps_si128(top), type));
+        type = _mm_and_si128(_mm_castps_si128(hit), type);
+        penetration = _mm_and_ps(hit, penetration);
+
+        // Interleave into {type, penetration} pairs
+        __m128 typeBits = _mm_castsi128_ps(type);
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i), _mm_unpacklo_ps(typeBits, penetration));
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i + 2), _mm_unpackhi_ps(typeBits, penetration));
+    }
+
+    CheckPaddleCollisionsScalar(ballX + i, ballY + i, ballVX + i, paddleX, paddleY + i, count - i, out + i);
+}
+
+void CheckWallCollisionsSSE2(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    const __m128 ballWidth = _mm_set1_ps(Ball_Width_F);
+    const __m128 ballHeight = _mm_set1_ps(Ball_Height_F);
+    const __m128 width = _mm_set1_ps(Width_F);
+    const __m128 height = _mm_set1_ps(Height_F);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128i typeLeft = _mm_set1_epi32(static_cast<int>(CollisionType::Left));
+    const __m128i typeRight = _mm_set1_epi32(static_cast<int>(CollisionType::Right));
+    const __m128i typeTop = _mm_set1_epi32(static_cast<int>(CollisionType::Top));
+    const __m128i typeBottom = _mm_set1_epi32(static_cast<int>(CollisionType::Bottom));
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 ballLeft = _mm_loadu_ps(ballX + i);
+        __m128 ballTop = _mm_loadu_ps(ballY + i);
+        __m128 ballRight = _mm_add_ps(ballLeft, ballWidth);
+        __m128 ballBottom = _mm_add_ps(ballTop, ballHeight);
+
+        // Each test only counts if none of the earlier ones in the else-if
+        // chain did
+        __m128 left = _mm_cmplt_ps(ballLeft, zero);
+        __m128 right = _mm_andnot_ps(left, _mm_cmpgt_ps(ballRight, width));
+        __m128 taken = _mm_or_ps(left, right);
+        __m128 top = _mm_andnot_ps(taken, _mm_cmplt_ps(ballTop, zero));
+        taken = _mm_or_ps(taken, top);
+        __m128 bottom = _mm_andnot_ps(taken, _mm_cmpgt_ps(ballBottom, height));
+
+        __m128i type = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(_mm_castps_si128(left), typeLeft),
+                         _mm_and_si128(_mm_castps_si128(right), typeRight)),
+            _mm_or_si128(_mm_and_si128(_mm_castps_si128(top), typeTop),
+                         _mm_and_si128(_mm_castps_si128(bottom), typeBottom)));
+
+        __m128 penetration = _mm_or_ps(_mm_and_ps(top, _mm_xor_ps(ballTop, signBit)),
+                                       _mm_and_ps(bottom, _mm_sub_ps(height, ballBottom)));
+
+        __m128 typeBits = _mm_castsi128_ps(type);
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i), _mm_unpacklo_ps(typeBits, penetration));
+        _mm_storeu_ps(reinterpret_cast<float *>(out + i + 2), _mm_unpackhi_ps(typeBits, penetration));
+    }
+
+    CheckWallCollisionsScalar(ballX + i, ballY + i, count - i, out + i);
+}
+
+__attribute__((target("avx2"))) void CheckPaddleCollisionsAVX2(float const *ballX, float const *ballY, float const *ballVX,
+                                                               float paddleX, float const *paddleY, int count, Contact *out)
+{
+    const __m256 ballWidth = _mm256_set1_ps(Ball_Width_F);
+    const __m256 ballHeight = _mm256_set1_ps(Ball_Height_F);
+    const __m256 paddleHeight = _mm256_set1_ps(Paddle_Height_F);
+    const __m256 rangeUpper = _mm256_set1_ps(Range_Upper);
+    const __m256 rangeMiddle = _mm256_set1_ps(Range_Middle);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 paddleLeft = _mm256_set1_ps(paddleX);
+    const __m256 paddleRight = _mm256_set1_ps(paddleX + Paddle_Width_F);
+    const __m256 typeTop = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Top)));
+    const __m256 typeMiddle = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Middle)));
+    const __m256 typeBottom = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Bottom)));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 ballLeft = _mm256_loadu_ps(ballX + i);
+        __m256 ballTop = _mm256_loadu_ps(ballY + i);
+        __m256 velocityX = _mm256_loadu_ps(ballVX + i);
+        __m256 paddleTop = _mm256_loadu_ps(paddleY + i);
+
+        __m256 ballRight = _mm256_add_ps(ballLeft, ballWidth);
+        __m256 ballBottom = _mm256_add_ps(ballTop, ballHeight);
+        __m256 paddleBottom = _mm256_add_ps(paddleTop, paddleHeight);
+
+        __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(ballLeft, paddleRight, _CMP_NGE_UQ),
+                                                 _mm256_cmp_ps(ballRight, paddleLeft, _CMP_NLE_UQ)),
+                                   _mm256_and_ps(_mm256_cmp_ps(ballTop, paddleBottom, _CMP_NGE_UQ),
+                                                 _mm256_cmp_ps(ballBottom, paddleTop, _CMP_NLE_UQ)));
+
+        __m256 movingLeft = _mm256_cmp_ps(velocityX, zero, _CMP_LT_OQ);
+        __m256 movingRight = _mm256_cmp_ps(velocityX, zero, _CMP_GT_OQ);
+        __m256 penetration = _mm256_or_ps(_mm256_and_ps(movingLeft, _mm256_sub_ps(paddleRight, ballLeft)),
+                                          _mm256_and_ps(movingRight, _mm256_sub_ps(paddleLeft, ballRight)));
+
+        __m256 paddleRangeUpper = _mm256_sub_ps(paddleBottom, rangeUpper);
+        __m256 paddleRangeMiddle = _mm256_sub_ps(paddleBottom, rangeMiddle);
+        __m256 top = _mm256_and_ps(_mm256_cmp_ps(ballBottom, paddleTop, _CMP_GT_OQ),
+                                   _mm256_cmp_ps(ballBottom, paddleRangeUpper, _CMP_LT_OQ));
+        __m256 middle = _mm256_and_ps(_mm256_cmp_ps(ballBottom, paddleRangeUpper, _CMP_GT_OQ),
+                                      _mm256_cmp_ps(ballBottom, paddleRangeMiddle, _CMP_LT_OQ));
+
+        __m256 type = _mm256_blendv_ps(typeBottom, typeMiddle, middle);
+        type = _mm256_blendv_ps(type, typeTop, top);
+        type = _mm256_and_ps(hit, type);
+        penetration = _mm256_and_ps(hit, penetration);
+
+        // unpack works per 128-bit half: lo = lanes 0,1,4,5 and hi = 2,3,6,7
+        __m256 lo = _mm256_unpacklo_ps(type, penetration);
+        __m256 hi = _mm256_unpackhi_ps(type, penetration);
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i + 4), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+    CheckPaddleCollisionsSSE2(ballX + i, ballY + i, ballVX + i, paddleX, paddleY + i, count - i, out + i);
+}
+
+__attribute__((target("avx2"))) void CheckWallCollisionsAVX2(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    const __m256 ballWidth = _mm256_set1_ps(Ball_Width_F);
+    const __m256 ballHeight = _mm256_set1_ps(Ball_Height_F);
+    const __m256 width = _mm256_set1_ps(Width_F);
+    const __m256 height = _mm256_set1_ps(Height_F);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 typeLeft = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Left)));
+    const __m256 typeRight = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Right)));
+    const __m256 typeTop = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Top)));
+    const __m256 typeBottom = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(CollisionType::Bottom)));
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 ballLeft = _mm256_loadu_ps(ballX + i);
+        __m256 ballTop = _mm256_loadu_ps(ballY + i);
+        __m256 ballRight = _mm256_add_ps(ballLeft, ballWidth);
+        __m256 ballBottom = _mm256_add_ps(ballTop, ballHeight);
+
+        __m256 left = _mm256_cmp_ps(ballLeft, zero, _CMP_LT_OQ);
+        __m256 right = _mm256_andnot_ps(left, _mm256_cmp_ps(ballRight, width, _CMP_GT_OQ));
+        __m256 taken = _mm256_or_ps(left, right);
+        __m256 top = _mm256_andnot_ps(taken, _mm256_cmp_ps(ballTop, zero, _CMP_LT_OQ));
+        taken = _mm256_or_ps(taken, top);
+        __m256 bottom = _mm256_andnot_ps(taken, _mm256_cmp_ps(ballBottom, height, _CMP_GT_OQ));
+
+        __m256 type = _mm256_or_ps(_mm256_or_ps(_mm256_and_ps(left, typeLeft), _mm256_and_ps(right, typeRight)),
+                                   _mm256_or_ps(_mm256_and_ps(top, typeTop), _mm256_and_ps(bottom, typeBottom)));
+
+        __m256 penetration = _mm256_or_ps(_mm256_and_ps(top, _mm256_xor_ps(ballTop, signBit)),
+                                          _mm256_and_ps(bottom, _mm256_sub_ps(height, ballBottom)));
+
+        __m256 lo = _mm256_unpacklo_ps(type, penetration);
+        __m256 hi = _mm256_unpackhi_ps(type, penetration);
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float *>(out + i + 4), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+    CheckWallCollisionsSSE2(ballX + i, ballY + i, count - i, out + i);
+}
+
+bool HasAVX2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#else
+
+void CheckPaddleCollisionsSSE2(float const *ballX, float const *ballY, float const *ballVX,
+                               float paddleX, float const *paddleY, int count, Contact *out)
+{
+    CheckPaddleCollisionsScalar(ballX, ballY, ballVX, paddleX, paddleY, count, out);
+}
+
+void CheckPaddleCollisionsAVX2(float const *ballX, float const *ballY, float const *ballVX,
+                               float paddleX, float const *paddleY, int count, Contact *out)
+{
+    CheckPaddleCollisionsScalar(ballX, ballY, ballVX, paddleX, paddleY, count, out);
+}
+
+void CheckWallCollisionsSSE2(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    CheckWallCollisionsScalar(ballX, ballY, count, out);
+}
+
+void CheckWallCollisionsAVX2(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    CheckWallCollisionsScalar(ballX, ballY, count, out);
+}
+
+bool HasAVX2()
+{
+    return false;
+}
+
+#endif
+
+void CheckPaddleCollisions(float const *ballX, float const *ballY, float const *ballVX,
+                           float paddleX, float const *paddleY, int count, Contact *out)
+{
+    if (HasAVX2())
+    {
+        CheckPaddleCollisionsAVX2(ballX, ballY, ballVX, paddleX, paddleY, count, out);
+    }
+    else
+    {
+        CheckPaddleCollisionsSSE2(ballX, ballY, ballVX, paddleX, paddleY, count, out);
+    }
+}
+
+void CheckWallCollisionsBatch(float const *ballX, float const *ballY, int count, Contact *out)
+{
+    if (HasAVX2())
+    {
+        CheckWallCollisionsAVX2(ballX, ballY, count, out);
+    }
+    else
+    {
+        CheckWallCollisionsSSE2(ballX, ballY, count, out);
+    }
+}
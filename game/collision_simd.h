@@ -0,0 +1,39 @@
+// Batched versions of chekcPaddleCollision and CheckWallCollisions.
+//
+// Balls come in as structure-of-arrays; every out[i] is exactly what the
+// scalar function returns for ball i. The scalar functions in pong.cpp stay
+// the reference, these just test 4 (SSE2) or 8 (AVX2) balls per instruction
+// with branchless masks.
+#pragma once
+
+#include "pong.h"
+
+// The x86 kernels need GCC/Clang's target attribute and cpu checks; with
+// other compilers (MSVC) every dispatcher runs the scalar version
+#if (defined(__SSE2__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define PONG_X86 1
+#include <immintrin.h>
+#endif
+
+// Ball i against a paddle at (paddleX, paddleY[i])
+void CheckPaddleCollisions(float const *ballX, float const *ballY, float const *ballVX,
+                           float paddleX, float const *paddleY, int count, Contact *out);
+
+void CheckWallCollisionsBatch(float const *ballX, float const *ballY, int count, Contact *out);
+
+// Specific implementations, mostly so they can be compared against each
+// other. The SIMD ones fall back to scalar for the tail and on CPUs (or
+// compilers) without the instruction set.
+void CheckPaddleCollisionsScalar(float const *ballX, float const *ballY, float const *ballVX,
+                                 float paddleX, float const *paddleY, int count, Contact *out);
+void CheckPaddleCollisionsSSE2(float const *ballX, float const *ballY, float const *ballVX,
+                               float paddleX, float const *paddleY, int count, Contact *out);
+void CheckPaddleCollisionsAVX2(float const *ballX, float const *ballY, float const *ballVX,
+                               float paddleX, float const *paddleY, int count, Contact *out);
+
+void CheckWallCollisionsScalar(float const *ballX, float const *ballY, int count, Contact *out);
+void CheckWallCollisionsSSE2(float const *ballX, float const *ballY, int count, Contact *out);
+void CheckWallCollisionsAVX2(float const *ballX, float const *ballY, int count, Contact *out);
+
+// True when this CPU can run the AVX2 kernels
+bool HasAVX2();
@@ -0,0 +1,134 @@
+#include "entities.h"
+
+using namespace std;
+
+// Call f on each float column the mask uses
+template <typename F>
+static void ForEachColumn(Archetype &archetype, F &&f)
+{
+    if (archetype.mask & Component_Position)
+    {
+        f(archetype.x);
+        f(archetype.y);
+        f(archetype.previousX);
+        f(archetype.previousY);
+    }
+    if (archetype.mask & Component_Velocity)
+    {
+        f(archetype.vx);
+        f(archetype.vy);
+    }
+    if (archetype.mask & Component_Extents)
+    {
+        f(archetype.width);
+        f(archetype.height);
+    }
+}
+
+int EntityStore::ArchetypeIndex(uint32_t mask)
+{
+    for (size_t i = 0; i < archetypes.size(); i++)
+    {
+        if (archetypes[i].mask == mask)
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    archetypes.emplace_back();
+    archetypes.back().mask = mask;
+    return static_cast<int>(archetypes.size()) - 1;
+}
+
+Entity EntityStore::Create(uint32_t mask)
+{
+    uint32_t index;
+    if (!freeSlots.empty())
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(slots.size());
+        slots.push_back({0, -1, -1});
+    }
+
+    int archetypeIndex = ArchetypeIndex(mask);
+    Archetype &archetype = archetypes[archetypeIndex];
+
+    slots[index].archetype = archetypeIndex;
+    slots[index].row = archetype.Size();
+
+    archetype.entities.push_back(index);
+    ForEachColumn(archetype, [](vector<float> &column) { column.push_back(0.0f); });
+
+    return {index, slots[index].generation};
+}
+
+void EntityStore::Destroy(Entity entity)
+{
+    if (!Alive(entity))
+    {
+        return;
+    }
+
+    Slot &slot = slots[entity.index];
+    Archetype &archetype = archetypes[slot.archetype];
+    int row = slot.row;
+    int last = archetype.Size() - 1;
+
+    // Swap-remove, and tell the moved entity where it lives now
+    if (row != last)
+    {
+        archetype.entities[row] = archetype.entities[last];
+        slots[archetype.entities[row]].row = row;
+    }
+    archetype.entities.pop_back();
+    ForEachColumn(archetype, [row, last](vector<float> &column)
+    {
+        column[row] = column[last];
+        column.pop_back();
+    });
+
+    ++slot.generation;
+    slot.archetype = -1;
+    slot.row = -1;
+    freeSlots.push_back(entity.index);
+}
+
+bool EntityStore::Alive(Entity entity) const
+{
+    return entity.index < slots.size() &&
+           slots[entity.index].generation == entity.generation &&
+           slots[entity.index].archetype >= 0;
+}
+
+Archetype &EntityStore::Locate(Entity entity, int &row)
+{
+    Slot const &slot = slots[entity.index];
+    row = slot.row;
+    return archetypes[slot.archetype];
+}
+
+void IntegrateSystem(EntityStore &store, float dt)
+{
+    store.ForEach(Component_Position | Component_Velocity, [dt](Archetype &archetype)
+    {
+        const int count = archetype.Size();
+        float *x = archetype.x.data();
+        float *y = archetype.y.data();
+        float *previousX = archetype.previousX.data();
+        float *previousY = archetype.previousY.data();
+        float const *vx = archetype.vx.data();
+        float const *vy = archetype.vy.data();
+
+        for (int i = 0; i < count; i++)
+        {
+            previousX[i] = x[i];
+            previousY[i] = y[i];
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+        }
+    });
+}
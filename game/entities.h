@@ -0,0 +1,96 @@
+// Entity-component store for modes with lots of things on the field.
+//
+// Entities with the same set of components share an archetype, and an
+// archetype keeps each component in its own dense array. A system names
+// the components it needs and walks just those arrays of the archetypes
+// that have them, so new kinds of entity (extra paddles, obstacles,
+// power-ups) with components of their own don't widen what the ball loop
+// streams through.
+//
+// Match keeps plain Ball and Paddle objects: with three things on the field
+// there's nothing to win, and rollback and replays want its flat GameState.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Component bits. Ball and Paddle are tags: no data, they only keep the
+// two kinds in separate archetypes.
+enum Components : uint32_t
+{
+    Component_Position = 1 << 0, // x, y (top-left) and previousX, previousY
+    Component_Velocity = 1 << 1, // vx, vy in px/ms
+    Component_Extents = 1 << 2,  // width, height
+    Component_Ball = 1 << 3,
+    Component_Paddle = 1 << 4,
+};
+
+// Handle to an entity. Stops being Alive once the entity is destroyed, even
+// after its slot gets reused.
+struct Entity
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
+// All entities with exactly the components in mask. Row r of every column
+// belongs to entities[r]; columns of components not in mask stay empty.
+struct Archetype
+{
+    uint32_t mask;
+    std::vector<uint32_t> entities;
+
+    std::vector<float> x, y, previousX, previousY;
+    std::vector<float> vx, vy;
+    std::vector<float> width, height;
+
+    int Size() const { return static_cast<int>(entities.size()); }
+};
+
+class EntityStore
+{
+public:
+    // New entity with its components zeroed
+    Entity Create(uint32_t mask);
+
+    // Moves the archetype's last row into the hole, so rows aren't stable
+    void Destroy(Entity entity);
+
+    bool Alive(Entity entity) const;
+
+    // Archetype and row of a live entity
+    Archetype &Locate(Entity entity, int &row);
+
+    // Index of the archetype for exactly this mask, made if needed. Indices
+    // stay valid as archetypes are added, references into archetypes don't.
+    int ArchetypeIndex(uint32_t mask);
+
+    // f(Archetype &) for every non-empty archetype with at least required
+    template <typename F>
+    void ForEach(uint32_t required, F &&f)
+    {
+        for (Archetype &archetype : archetypes)
+        {
+            if ((archetype.mask & required) == required && archetype.Size() > 0)
+            {
+                f(archetype);
+            }
+        }
+    }
+
+    std::vector<Archetype> archetypes;
+
+private:
+    struct Slot
+    {
+        uint32_t generation;
+        int archetype;
+        int row;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
+
+// previousX/Y = x/y, then x/y += velocity * dt, for everything that moves
+void IntegrateSystem(EntityStore &store, float dt);
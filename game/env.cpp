@@ -0,0 +1,117 @@
+#include "env.h"
+
+#include "ai.h"
+
+using namespace std;
+
+VecEnv::VecEnv(EnvConfig const &config, WorkStealingPool *pool)
+    : config(config), pool(pool)
+{
+    matchEpisodes.assign(config.count, 0);
+    matchTicks.assign(config.count, 0);
+
+    matches.reserve(config.count);
+    for (int i = 0; i < config.count; i++)
+    {
+        matches.push_back(NewMatch(i));
+    }
+}
+
+Match VecEnv::NewMatch(int i) const
+{
+    return Match(SeedFor(SeedFor(config.seed, i), matchEpisodes[i]));
+}
+
+static void Observe(Match const &match, float *out)
+{
+    out[0] = match.ball.position.x * (1.0f / WIDTH);
+    out[1] = match.ball.position.y * (1.0f / HEIGHT);
+    out[2] = match.ball.velocity.x * (1.0f / Ball_Speed);
+    out[3] = match.ball.velocity.y * (1.0f / Ball_Speed);
+    out[4] = match.paddle1.position.y * (1.0f / HEIGHT);
+    out[5] = match.paddle2.position.y * (1.0f / HEIGHT);
+}
+
+void VecEnv::Reset(float *observations)
+{
+    fill(matchEpisodes.begin(), matchEpisodes.end(), 0);
+    fill(matchTicks.begin(), matchTicks.end(), 0);
+    episodes = 0;
+
+    for (int i = 0; i < config.count; i++)
+    {
+        matches[i] = NewMatch(i);
+        Observe(matches[i], observations + i * Env_Observation_Size);
+    }
+}
+
+void VecEnv::StepRange(int begin, int end, uint8_t const *actions, float *observations, float *rewards, uint8_t *dones)
+{
+    for (int i = begin; i < end; i++)
+    {
+        Match &match = matches[i];
+
+        bool buttons[4];
+        UnpackButtons(actions[i], buttons);
+
+        if (config.opponent == Opponent::Chase)
+        {
+            ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        }
+        else if (config.opponent == Opponent::Intercept)
+        {
+            InterceptBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        }
+
+        match.SetButtons(buttons);
+        CollisionType scored = match.Tick(config.tickDt);
+
+        // Left means the ball went out on paddle one's side
+        rewards[i] = scored == CollisionType::Right ? 1.0f : (scored == CollisionType::Left ? -1.0f : 0.0f);
+
+        bool done = match.playerOneScore >= config.scoreLimit ||
+                    match.playerTwoScore >= config.scoreLimit ||
+                    ++matchTicks[i] >= config.maxTicks;
+        dones[i] = done;
+
+        if (done)
+        {
+            ++matchEpisodes[i];
+            matchTicks[i] = 0;
+            match = NewMatch(i);
+        }
+
+        Observe(match, observations + i * Env_Observation_Size);
+    }
+}
+
+void VecEnv::Step(uint8_t const *actions, float *observations, float *rewards, uint8_t *dones)
+{
+    int chunks = (config.count + Env_Chunk_Size - 1) / Env_Chunk_Size;
+
+    if (pool == nullptr || pool->WorkerCount() == 1 || chunks == 1)
+    {
+        StepRange(0, config.count, actions, observations, rewards, dones);
+    }
+    else
+    {
+        // Only `this` goes in the lambda so std::function keeps it inline
+        // instead of allocating every step
+        stepActions = actions;
+        stepObservations = observations;
+        stepRewards = rewards;
+        stepDones = dones;
+
+        pool->Run(chunks, [this](int chunk, int) {
+            int begin = chunk * Env_Chunk_Size;
+            int end = begin + Env_Chunk_Size < config.count ? begin + Env_Chunk_Size : config.count;
+            StepRange(begin, end, stepActions, stepObservations, stepRewards, stepDones);
+        });
+    }
+
+    // Count the finished ones here rather than sharing a counter
+    for (int i = 0; i < config.count; i++)
+    {
+        episodes += dones[i];
+    }
+}
@@ -0,0 +1,81 @@
+// Reinforcement-learning style front end: many matches stepped together
+// behind one Step(actions) -> observations, rewards, dones call.
+//
+// The agent plays paddle one; paddle two is one of the built-in AIs or
+// also driven through the actions. Every buffer belongs to the caller and
+// is written in place, so a step allocates nothing. A match that ends is
+// reset right away: its done flag and final reward come back with the
+// first observation of the next match.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pong.h"
+#include "runner.h"
+
+// Floats per observation: ball x, y, vx, vy, then paddle one and two y.
+// Positions are scaled to [0, 1] of the field, velocities to Ball_Speed.
+const int Env_Observation_Size = 6;
+
+// Matches per pool task when stepping on a pool
+const int Env_Chunk_Size = 512;
+
+enum class Opponent
+{
+    Agent,     // Actions drive both paddles
+    Chase,     // ChaseBall
+    Intercept, // InterceptBall
+};
+
+struct EnvConfig
+{
+    int count = 1024;
+    uint64_t seed = 1;
+    int scoreLimit = 11;
+    long maxTicks = 72000; // An episode ends here even without a winner
+    float tickDt = 1000.0f / Tick_Rate;
+    Opponent opponent = Opponent::Chase;
+};
+
+class VecEnv
+{
+public:
+    // Without a pool everything runs on the calling thread
+    explicit VecEnv(EnvConfig const &config, WorkStealingPool *pool = nullptr);
+
+    int Count() const { return config.count; }
+
+    // Start every match over and write count * Env_Observation_Size floats
+    void Reset(float *observations);
+
+    // actions[i] is a Buttons mask for match i (PackButtons); with a
+    // built-in opponent only paddle one's bits are used. rewards[i] is +1
+    // when paddle one scored this step, -1 when paddle two did. dones[i] is
+    // 1 when the match ended (and was reset).
+    void Step(uint8_t const *actions, float *observations, float *rewards, uint8_t *dones);
+
+    // Matches finished since the last Reset
+    long long Episodes() const { return episodes; }
+
+private:
+    void StepRange(int begin, int end, uint8_t const *actions, float *observations, float *rewards, uint8_t *dones);
+
+    // Episode n of match i gets its own seed, so results don't depend on
+    // how the matches were spread over threads
+    Match NewMatch(int i) const;
+
+    EnvConfig config;
+    WorkStealingPool *pool;
+
+    std::vector<Match> matches;
+    std::vector<uint32_t> matchEpisodes;
+    std::vector<int32_t> matchTicks;
+    long long episodes = 0;
+
+    // Step's buffers, for the pool's workers
+    uint8_t const *stepActions = nullptr;
+    float *stepObservations = nullptr;
+    float *stepRewards = nullptr;
+    uint8_t *stepDones = nullptr;
+};
@@ -0,0 +1,234 @@
+#include "framebuffer.h"
+
+#include "collision_simd.h"
+
+using namespace std;
+
+static bool avx2Spans = HasAVX2();
+
+void UseAVX2Spans(bool use)
+{
+    avx2Spans = use && HasAVX2();
+}
+
+Framebuffer::Framebuffer(int width, int height)
+    : storage(static_cast<size_t>(width) * height), pixels(storage.data()), width(width), height(height), stride(width),
+      clip{0, 0, width, height}
+{
+}
+
+Framebuffer::Framebuffer(uint32_t *pixels, int width, int height, int pitch)
+    : pixels(pixels), width(width), height(height), stride(pitch / 4), clip{0, 0, width, height}
+{
+}
+
+void Framebuffer::SetClip(Rect const &rect)
+{
+    clip = Intersection(rect, {0, 0, width, height});
+}
+
+void Framebuffer::ResetClip()
+{
+    clip = {0, 0, width, height};
+}
+
+void Framebuffer::Clear(uint32_t color)
+{
+    if (stride == width && clip == Rect{0, 0, width, height})
+    {
+        // One long span, no per-row tails
+        FillSpan(pixels, width * height, color);
+        return;
+    }
+
+    FillRect(clip, color);
+}
+
+void Framebuffer::FillRect(Rect const &rect, uint32_t color)
+{
+    Rect clipped = Intersection(rect, clip);
+    if (IsEmpty(clipped))
+    {
+        return;
+    }
+
+    for (int y = clipped.y; y < clipped.y + clipped.h; y++)
+    {
+        FillSpan(Row(y) + clipped.x, clipped.w, color);
+    }
+}
+
+void Framebuffer::FillRects(Rect const *rects, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+    {
+        FillRect(rects[i], color);
+    }
+}
+
+void Framebuffer::DrawPoints(Point const *points, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+    {
+        // Unsigned compare does both ends at once
+        if (static_cast<unsigned>(points[i].x - clip.x) < static_cast<unsigned>(clip.w) &&
+            static_cast<unsigned>(points[i].y - clip.y) < static_cast<unsigned>(clip.h))
+        {
+            Row(points[i].y)[points[i].x] = color;
+        }
+    }
+}
+
+void Framebuffer::BlitMask(int x, int y, uint8_t const *mask, int maskWidth, int maskHeight, int maskPitch, uint32_t color)
+{
+    Rect clipped = Intersection({x, y, maskWidth, maskHeight}, clip);
+    if (IsEmpty(clipped))
+    {
+        return;
+    }
+
+    for (int row = clipped.y; row < clipped.y + clipped.h; row++)
+    {
+        uint8_t const *maskRow = mask + static_cast<size_t>(row - y) * maskPitch + (clipped.x - x);
+        BlendMaskSpan(Row(row) + clipped.x, maskRow, clipped.w, color);
+    }
+}
+
+void FillSpanScalar(uint32_t *dst, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+void BlendMaskSpanScalar(uint32_t *dst, uint8_t const *mask, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (mask[i] != 0)
+        {
+            dst[i] = color;
+        }
+    }
+}
+
+#ifdef PONG_X86
+
+void FillSpanSSE2(uint32_t *dst, int count, uint32_t color)
+{
+    const __m128i fill = _mm_set1_epi32(static_cast<int>(color));
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), fill);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), fill);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), fill);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 12), fill);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), fill);
+    }
+    for (; i < count; i++)
+    {
+        dst[i] = color;
+    }
+}
+
+__attribute__((target("avx2"))) void FillSpanAVX2(uint32_t *dst, int count, uint32_t color)
+{
+    const __m256i fill = _mm256_set1_epi32(static_cast<int>(color));
+
+    int i = 0;
+
+    // Long spans (clears, wide rects): one unaligned store, then carry on
+    // from the next 32-byte boundary so no store splits a cache line
+    if (count >= 64)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), fill);
+        i = static_cast<int>((32 - (reinterpret_cast<uintptr_t>(dst) & 31)) / 4);
+    }
+
+    // The tail is one masked store
+    for (; i + 32 <= count; i += 32)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), fill);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8), fill);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 16), fill);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 24), fill);
+    }
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), fill);
+    }
+    if (i < count)
+    {
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i live = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i), lanes);
+        _mm256_maskstore_epi32(reinterpret_cast<int *>(dst + i), live, fill);
+    }
+}
+
+__attribute__((target("avx2"))) void BlendMaskSpanAVX2(uint32_t *dst, uint8_t const *mask, int count, uint32_t color)
+{
+    const __m256i fill = _mm256_set1_epi32(static_cast<int>(color));
+    const __m256i zero = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // 8 mask bytes widened to one lane each; the store only touches
+        // lanes that are set
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(mask + i));
+        __m256i wide = _mm256_cvtepu8_epi32(bytes);
+        __m256i set = _mm256_xor_si256(_mm256_cmpeq_epi32(wide, zero), _mm256_set1_epi32(-1));
+        _mm256_maskstore_epi32(reinterpret_cast<int *>(dst + i), set, fill);
+    }
+
+    BlendMaskSpanScalar(dst + i, mask + i, count - i, color);
+}
+
+#else
+
+void FillSpanSSE2(uint32_t *dst, int count, uint32_t color)
+{
+    FillSpanScalar(dst, count, color);
+}
+
+void FillSpanAVX2(uint32_t *dst, int count, uint32_t color)
+{
+    FillSpanScalar(dst, count, color);
+}
+
+void BlendMaskSpanAVX2(uint32_t *dst, uint8_t const *mask, int count, uint32_t color)
+{
+    BlendMaskSpanScalar(dst, mask, count, color);
+}
+
+#endif
+
+void FillSpan(uint32_t *dst, int count, uint32_t color)
+{
+    if (avx2Spans)
+    {
+        FillSpanAVX2(dst, count, color);
+    }
+    else
+    {
+        FillSpanSSE2(dst, count, color);
+    }
+}
+
+void BlendMaskSpan(uint32_t *dst, uint8_t const *mask, int count, uint32_t color)
+{
+    if (avx2Spans)
+    {
+        BlendMaskSpanAVX2(dst, mask, count, color);
+    }
+    else
+    {
+        BlendMaskSpanScalar(dst, mask, count, color);
+    }
+}
@@ -0,0 +1,118 @@
+// Software rasterizer: rectangles, points and glyph masks drawn straight
+// into 32-bit pixels on the CPU, for running without a GPU (kiosks,
+// remote desktops) and for comparing against SDL's renderer.
+//
+// Pixels are ARGB8888 (0xAARRGGBB), which is also what SDL calls RGB888
+// when the alpha byte is ignored. Everything is clipped to the clip rect,
+// which is the whole buffer unless SetClip says otherwise.
+// Every row is filled as one span; spans go through AVX2 when the CPU has
+// it, and SSE2 otherwise.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// main()'s colors
+const uint32_t Color_Background = 0xFFFF80FF;
+const uint32_t Color_Foreground = 0xFFFFFF00;
+
+struct Rect
+{
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+struct Point
+{
+    int x = 0;
+    int y = 0;
+};
+
+inline bool IsEmpty(Rect const &rect)
+{
+    return rect.w <= 0 || rect.h <= 0;
+}
+
+inline Rect Intersection(Rect const &a, Rect const &b)
+{
+    int left = a.x > b.x ? a.x : b.x;
+    int top = a.y > b.y ? a.y : b.y;
+    int right = a.x + a.w < b.x + b.w ? a.x + a.w : b.x + b.w;
+    int bottom = a.y + a.h < b.y + b.h ? a.y + a.h : b.y + b.h;
+    return {left, top, right - left, bottom - top};
+}
+
+// Smallest rect holding both
+inline Rect Union(Rect const &a, Rect const &b)
+{
+    int left = a.x < b.x ? a.x : b.x;
+    int top = a.y < b.y ? a.y : b.y;
+    int right = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int bottom = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return {left, top, right - left, bottom - top};
+}
+
+inline bool operator==(Rect const &a, Rect const &b)
+{
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+class Framebuffer
+{
+public:
+    // Owns its pixels
+    Framebuffer(int width, int height);
+
+    // Draws into someone else's pixels (a window surface, a locked
+    // texture). pitch is in bytes and must be a multiple of 4.
+    Framebuffer(uint32_t *pixels, int width, int height, int pitch);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int Pitch() const { return stride * 4; }
+    uint32_t *Pixels() { return pixels; }
+    uint32_t const *Pixels() const { return pixels; }
+    uint32_t *Row(int y) { return pixels + static_cast<size_t>(y) * stride; }
+
+    // Limit drawing to part of the buffer, e.g. one damaged rect
+    void SetClip(Rect const &rect);
+    void ResetClip();
+    Rect Clip() const { return clip; }
+
+    // Fills the clip rect
+    void Clear(uint32_t color);
+    void FillRect(Rect const &rect, uint32_t color);
+    void FillRects(Rect const *rects, int count, uint32_t color);
+    void DrawPoints(Point const *points, int count, uint32_t color);
+
+    // color wherever mask is non-zero, the rest left alone. An 8-bit
+    // surface from TTF_RenderText_Solid is such a mask (index 0 is the
+    // background).
+    void BlitMask(int x, int y, uint8_t const *mask, int maskWidth, int maskHeight, int maskPitch, uint32_t color);
+
+private:
+    std::vector<uint32_t> storage;
+    uint32_t *pixels;
+    int width;
+    int height;
+    int stride; // In pixels
+    Rect clip;
+};
+
+// One row's worth of pixels set to color
+void FillSpan(uint32_t *dst, int count, uint32_t color);
+void FillSpanScalar(uint32_t *dst, int count, uint32_t color);
+void FillSpanSSE2(uint32_t *dst, int count, uint32_t color);
+void FillSpanAVX2(uint32_t *dst, int count, uint32_t color);
+
+// dst[i] = color where mask[i] != 0
+void BlendMaskSpan(uint32_t *dst, uint8_t const *mask, int count, uint32_t color);
+void BlendMaskSpanScalar(uint32_t *dst, uint8_t const *mask, int count, uint32_t color);
+void BlendMaskSpanAVX2(uint32_t *dst, uint8_t const *mask, int count, uint32_t color);
+
+// Pick the span kernels: false forces the SSE2/scalar ones even on an
+// AVX2 CPU, to compare the two
+void UseAVX2Spans(bool use);
@@ -0,0 +1,355 @@
+#include "multiball.h"
+
+#include "profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static const uint32_t Ball_Components = Component_Position | Component_Velocity | Component_Extents | Component_Ball;
+static const uint32_t Paddle_Components = Component_Position | Component_Velocity | Component_Extents | Component_Paddle;
+
+Arena::Arena(uint64_t seed) : rng(seed)
+{
+    ballArchetype = entities.ArchetypeIndex(Ball_Components);
+    paddleArchetype = entities.ArchetypeIndex(Paddle_Components);
+
+    columns = (WIDTH + Arena_Cell_Size - 1) / Arena_Cell_Size;
+    rows = (HEIGHT + Arena_Cell_Size - 1) / Arena_Cell_Size;
+    cellStart.resize(columns * rows + 1);
+}
+
+void Arena::AddStandardPaddles()
+{
+    AddPaddle(50.0f, HEIGHT / 2.0f);
+    AddPaddle(WIDTH - 50.0f, HEIGHT / 2.0f);
+}
+
+Entity Arena::AddPaddle(float x, float y)
+{
+    Entity entity = entities.Create(Paddle_Components);
+
+    int row;
+    Archetype &paddles = entities.Locate(entity, row);
+    paddles.x[row] = paddles.previousX[row] = x;
+    paddles.y[row] = paddles.previousY[row] = y;
+    paddles.width[row] = Paddle_Width;
+    paddles.height[row] = Paddle_Height;
+
+    if (players.size() < 2)
+    {
+        players.push_back(entity);
+    }
+    return entity;
+}
+
+void Arena::ServeBalls(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        Entity entity = entities.Create(Ball_Components);
+
+        int row;
+        Archetype &balls = entities.Locate(entity, row);
+        balls.width[row] = Ball_Width;
+        balls.height[row] = Ball_Height;
+
+        // Alternating sides
+        Serve(balls, row, i % 2 ? CollisionType::Left : CollisionType::Right);
+    }
+}
+
+void Arena::Serve(Archetype &balls, int row, CollisionType side)
+{
+    // Same serve as after a point in a match
+    Ball ball(Vec2(balls.x[row], balls.y[row]), Vec2(balls.vx[row], balls.vy[row]));
+    Contact contact{side, 0.0f};
+    ball.CollideWithWall(contact, rng);
+
+    // Spread them out so they don't all move as one block, or pile up on
+    // the center spot when ball collisions are on
+    ball.position.x += (rng.NextFloat() - 0.5f) * WIDTH / 2.0f;
+    ball.position.y = rng.NextFloat() * (HEIGHT - Ball_Height);
+
+    balls.x[row] = balls.previousX[row] = ball.position.x;
+    balls.y[row] = balls.previousY[row] = ball.position.y;
+    balls.vx[row] = ball.velocity.x;
+    balls.vy[row] = ball.velocity.y;
+}
+
+void Arena::SetButtons(bool const buttons[4])
+{
+    if (players.size() < 2)
+    {
+        return;
+    }
+
+    float velocity[2] = {
+        buttons[Buttons::PaddleOneUP] ? -Paddle_Speed : (buttons[Buttons::PaddleOneDown] ? Paddle_Speed : 0.0f),
+        buttons[Buttons::PaddleTwoUp] ? -Paddle_Speed : (buttons[Buttons::PaddleTwoDown] ? Paddle_Speed : 0.0f),
+    };
+
+    for (int player = 0; player < 2; player++)
+    {
+        int row;
+        Archetype &paddles = entities.Locate(players[player], row);
+        paddles.vy[row] = velocity[player];
+    }
+}
+
+static int Clamp(int value, int low, int high)
+{
+    return value < low ? low : (value > high ? high : value);
+}
+
+void Arena::BuildGrid(Archetype const &balls)
+{
+    const int cells = columns * rows;
+    const int count = balls.Size();
+
+    ballCell.resize(count);
+    cellBalls.resize(count);
+    fill(cellStart.begin(), cellStart.end(), 0);
+
+    // Count per cell, prefix sum, then scatter
+    for (int i = 0; i < count; i++)
+    {
+        int column = Clamp(static_cast<int>(balls.x[i]) / Arena_Cell_Size, 0, columns - 1);
+        int row = Clamp(static_cast<int>(balls.y[i]) / Arena_Cell_Size, 0, rows - 1);
+        ballCell[i] = row * columns + column;
+        ++cellStart[ballCell[i] + 1];
+    }
+
+    for (int c = 0; c < cells; c++)
+    {
+        cellStart[c + 1] += cellStart[c];
+    }
+
+    // cellStart[c] doubles as the write cursor and ends up at the start of
+    // cell c + 1, so shift back afterwards
+    for (int i = 0; i < count; i++)
+    {
+        cellBalls[cellStart[ballCell[i]]++] = i;
+    }
+    for (int c = cells; c > 0; c--)
+    {
+        cellStart[c] = cellStart[c - 1];
+    }
+    cellStart[0] = 0;
+}
+
+void Arena::Step(float dt)
+{
+    PROFILE_START(ballTimer, Phase_Ball);
+    IntegrateSystem(entities, dt);
+    PROFILE_STOP(ballTimer);
+
+    Archetype &balls = entities.archetypes[ballArchetype];
+    Archetype &paddles = entities.archetypes[paddleArchetype];
+    const int ballCount = balls.Size();
+
+    // Keep the paddles on the field, as Paddle::update does
+    PROFILE_START(paddleTimer, Phase_Paddles);
+    for (int p = 0; p < paddles.Size(); p++)
+    {
+        float bottom = HEIGHT - paddles.height[p];
+        paddles.y[p] = paddles.y[p] < 0.0f ? 0.0f : (paddles.y[p] > bottom ? bottom : paddles.y[p]);
+    }
+    PROFILE_STOP(paddleTimer);
+
+    PROFILE_SCOPE(Phase_Collision);
+
+    if (ballCollisions)
+    {
+        CollideBalls(balls);
+    }
+
+    BuildGrid(balls);
+
+    bounced.assign(ballCount, 0);
+    narrowTests = 0;
+
+    for (int p = 0; p < paddles.Size(); p++)
+    {
+        Paddle paddle(Vec2(paddles.x[p], paddles.y[p]), Vec2(paddles.vx[p], paddles.vy[p]));
+
+        // A ball touches the paddle only if its top-left corner is within
+        // one ball size above/left of the paddle's box
+        int firstColumn = Clamp(static_cast<int>(paddle.position.x - Ball_Width) / Arena_Cell_Size, 0, columns - 1);
+        int lastColumn = Clamp(static_cast<int>(paddle.position.x + Paddle_Width) / Arena_Cell_Size, 0, columns - 1);
+        int firstRow = Clamp(static_cast<int>(paddle.position.y - Ball_Height) / Arena_Cell_Size, 0, rows - 1);
+        int lastRow = Clamp(static_cast<int>(paddle.position.y + Paddle_Height) / Arena_Cell_Size, 0, rows - 1);
+
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            for (int column = firstColumn; column <= lastColumn; column++)
+            {
+                int cell = row * columns + column;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++)
+                {
+                    int i = cellBalls[k];
+                    if (bounced[i])
+                    {
+                        continue;
+                    }
+
+                    ++narrowTests;
+                    Ball ball(Vec2(balls.x[i], balls.y[i]), Vec2(balls.vx[i], balls.vy[i]));
+                    if (Contact contact = chekcPaddleCollision(ball, paddle);
+                        contact.type != CollisionType::None)
+                    {
+                        ball.CollisionWithPaddle(contact);
+                        balls.x[i] = ball.position.x;
+                        balls.vx[i] = ball.velocity.x;
+                        balls.vy[i] = ball.velocity.y;
+                        bounced[i] = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < ballCount; i++)
+    {
+        // Most balls are nowhere near a wall (the exact opposite of the
+        // tests in CheckWallCollisions)
+        if (bounced[i] ||
+            (balls.x[i] >= 0.0f && balls.x[i] + Ball_Width <= WIDTH &&
+             balls.y[i] >= 0.0f && balls.y[i] + Ball_Height <= HEIGHT))
+        {
+            continue;
+        }
+
+        Ball ball(Vec2(balls.x[i], balls.y[i]), Vec2(balls.vx[i], balls.vy[i]));
+        if (Contact contact = CheckWallCollisions(ball);
+            contact.type != CollisionType::None)
+        {
+            if (contact.type == CollisionType::Left)
+            {
+                ++playerTwoScore;
+                Serve(balls, i, contact.type);
+            }
+            else if (contact.type == CollisionType::Right)
+            {
+                ++playerOneScore;
+                Serve(balls, i, contact.type);
+            }
+            else
+            {
+                ball.CollideWithWall(contact, rng);
+                balls.y[i] = ball.position.y;
+                balls.vy[i] = ball.velocity.y;
+            }
+        }
+    }
+}
+
+void Arena::CollideBalls(Archetype &balls)
+{
+    const int count = balls.Size();
+
+    // Sort by left edge
+    sweep.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        sweep[i] = {balls.x[i], balls.y[i], i};
+    }
+    sort(sweep.begin(), sweep.end(), [](SweepEntry const &a, SweepEntry const &b) { return a.left < b.left; });
+
+    // Sweep: anything starting more than a ball width to the right can't
+    // overlap, and neither can anything after it. The y test decides about
+    // one pair in twenty, so rather than branch on it every candidate gets
+    // written and the cursor only moves past the ones that overlap.
+    SweepEntry const *entries = sweep.data();
+    long long pairTests = 0;
+    size_t found = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        float right = entries[i].left + Ball_Width;
+        float top = entries[i].top;
+
+        int last = i + 1;
+        while (last < count && entries[last].left < right)
+        {
+            last++;
+        }
+        pairTests += last - (i + 1);
+
+        if (found + (last - (i + 1)) > overlaps.size())
+        {
+            overlaps.resize(max(overlaps.size() * 2, found + (last - (i + 1))));
+        }
+
+        SweepPair *out = overlaps.data();
+        for (int j = i + 1; j < last; j++)
+        {
+            out[found] = {i, j};
+            found += fabs(entries[j].top - top) < Ball_Height;
+        }
+    }
+
+    // Push apart along whichever axis overlaps least
+    contacts.clear();
+    for (size_t k = 0; k < found; k++)
+    {
+        SweepEntry const &first = entries[overlaps[k].first];
+        SweepEntry const &second = entries[overlaps[k].second];
+        float dx = second.left - first.left;
+        float dy = second.top - first.top;
+        float overlapX = Ball_Width - dx;
+        float overlapY = Ball_Height - fabs(dy);
+
+        BallContact contact{first.ball, second.ball, {}};
+        if (overlapX < overlapY)
+        {
+            contact.contact.type = CollisionType::Right;
+            contact.contact.penetration = overlapX;
+        }
+        else
+        {
+            contact.contact.type = dy < 0.0f ? CollisionType::Top : CollisionType::Bottom;
+            contact.contact.penetration = overlapY;
+        }
+        contacts.push_back(contact);
+    }
+
+    ballPairTests = pairTests;
+    ballContacts = static_cast<long long>(contacts.size());
+
+    float *x = balls.x.data();
+    float *y = balls.y.data();
+    float *vx = balls.vx.data();
+    float *vy = balls.vy.data();
+
+    for (BallContact const &contact : contacts)
+    {
+        int first = contact.first;
+        int second = contact.second;
+        float half = contact.contact.penetration / 2.0f;
+
+        if (contact.contact.type == CollisionType::Right)
+        {
+            x[first] -= half;
+            x[second] += half;
+
+            // Equal masses, elastic: swap the normal velocities if closing
+            if (vx[first] > vx[second])
+            {
+                swap(vx[first], vx[second]);
+            }
+        }
+        else
+        {
+            float direction = contact.contact.type == CollisionType::Bottom ? 1.0f : -1.0f;
+            y[first] -= half * direction;
+            y[second] += half * direction;
+
+            if ((vy[first] - vy[second]) * direction > 0.0f)
+            {
+                swap(vy[first], vy[second]);
+            }
+        }
+    }
+}
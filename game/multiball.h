@@ -0,0 +1,103 @@
+// Multi-ball mode: any number of balls and paddles on the standard field.
+//
+// Balls and paddles live in an EntityStore, one archetype each, and the
+// hot loops below run straight over those columns.
+//
+// Each tick the balls are bucketed into a uniform grid (a counting sort on
+// the cell of their top-left corner). A paddle then only runs the narrow
+// phase, chekcPaddleCollision, against balls in the cells its box can
+// reach, so that work follows actual overlaps rather than balls x paddles.
+//
+// With ballCollisions on, balls also bounce off each other. Candidate pairs
+// come from sort-and-sweep: sort by left edge, then only compare a ball
+// with the ones whose left edge is within one ball width after it.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "entities.h"
+#include "pong.h"
+
+// Bigger than a ball, so a ball's top-left cell and its neighbours below
+// and to the right cover everything it touches
+const int Arena_Cell_Size = 64;
+
+// Two overlapping balls. contact.type is the side of first that second
+// touches (Left/Right/Top/Bottom) and penetration how deep they overlap
+// along that axis.
+struct BallContact
+{
+    int first;
+    int second;
+    Contact contact;
+};
+
+class Arena
+{
+public:
+    explicit Arena(uint64_t seed = 1);
+
+    // Two paddles in the usual places plus count balls served from the
+    // center in random directions
+    void AddStandardPaddles();
+    void ServeBalls(int count);
+
+    // A still paddle with its top-left corner at x, y. The first two are
+    // the ones SetButtons moves.
+    Entity AddPaddle(float x, float y);
+
+    // Paddles 0 and 1 take the Buttons like in Match
+    void SetButtons(bool const buttons[4]);
+
+    void Step(float dt);
+
+    int BallCount() const { return entities.archetypes[ballArchetype].Size(); }
+    int PaddleCount() const { return entities.archetypes[paddleArchetype].Size(); }
+
+    EntityStore entities;
+
+    int playerOneScore = 0;
+    int playerTwoScore = 0;
+
+    // Balls bounce off each other too
+    bool ballCollisions = false;
+
+    // Narrow-phase tests run by the last Step
+    long long narrowTests = 0;
+    long long ballPairTests = 0;
+    long long ballContacts = 0;
+
+    Rng rng;
+
+private:
+    void BuildGrid(Archetype const &balls);
+    void CollideBalls(Archetype &balls);
+    void Serve(Archetype &balls, int row, CollisionType side);
+
+    int ballArchetype;
+    int paddleArchetype;
+    std::vector<Entity> players; // Paddles SetButtons drives
+
+    int columns;
+    int rows;
+    std::vector<int> cellStart; // Balls of cell c are cellBalls[cellStart[c] .. cellStart[c + 1])
+    std::vector<int> cellBalls;
+    std::vector<int> ballCell;
+    std::vector<uint8_t> bounced; // Ball already hit a paddle this tick
+
+    struct SweepEntry
+    {
+        float left;
+        float top; // Kept here so the sweep doesn't chase indices
+        int ball;
+    };
+    struct SweepPair
+    {
+        int first; // Indices into sweep
+        int second;
+    };
+    std::vector<SweepEntry> sweep;
+    std::vector<SweepPair> overlaps;
+    std::vector<BallContact> contacts;
+};
@@ -0,0 +1,145 @@
+#include "net.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+typedef SOCKET NativeSocket;
+static const NativeSocket No_Socket = INVALID_SOCKET;
+#else
+typedef int NativeSocket;
+static const NativeSocket No_Socket = -1;
+#endif
+
+static sockaddr_in LoopbackAddress(uint16_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+bool UdpSocket::Open(uint16_t wantedPort)
+{
+    Close();
+
+#ifdef _WIN32
+    static bool started = false;
+    if (!started)
+    {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }
+#endif
+
+    NativeSocket native = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (native == No_Socket)
+    {
+        cout << "Couldn't create UDP socket\n";
+        return false;
+    }
+    handle = static_cast<intptr_t>(native);
+
+    sockaddr_in address = LoopbackAddress(wantedPort);
+    if (bind(native, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        cout << "Couldn't bind UDP port " << wantedPort << '\n';
+        Close();
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(native, reinterpret_cast<sockaddr *>(&address), &length);
+    port = ntohs(address.sin_port);
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(native, FIONBIO, &nonBlocking);
+#else
+    fcntl(native, F_SETFL, fcntl(native, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    return true;
+}
+
+void UdpSocket::Close()
+{
+    if (handle == -1)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    closesocket(static_cast<NativeSocket>(handle));
+#else
+    close(static_cast<NativeSocket>(handle));
+#endif
+
+    handle = -1;
+    port = 0;
+}
+
+bool UdpSocket::SendTo(uint16_t toPort, void const *data, size_t size)
+{
+    sockaddr_in address = LoopbackAddress(toPort);
+    return sendto(static_cast<NativeSocket>(handle), static_cast<char const *>(data), static_cast<int>(size), 0,
+                  reinterpret_cast<sockaddr *>(&address), sizeof(address)) == static_cast<int>(size);
+}
+
+int UdpSocket::Receive(void *buffer, size_t size)
+{
+    int received = static_cast<int>(recv(static_cast<NativeSocket>(handle), static_cast<char *>(buffer),
+                                         static_cast<int>(size), 0));
+    return received < 0 ? -1 : received;
+}
+
+LaggyLink::LaggyLink(UdpSocket &socket, uint16_t toPort, float rttMs, float jitterMs, uint64_t seed)
+    : socket(socket), toPort(toPort), oneWayMs(rttMs / 2.0f), jitterMs(jitterMs), rng(seed)
+{
+}
+
+void LaggyLink::Send(double nowMs, uint8_t const *data, size_t size)
+{
+    double delay = oneWayMs + (rng.NextFloat() * 2.0f - 1.0f) * jitterMs;
+    pending.push_back({nowMs + (delay > 0.0 ? delay : 0.0), vector<uint8_t>(data, data + size)});
+}
+
+void LaggyLink::Flush(double nowMs)
+{
+    // Jitter means packets can overtake each other, just like the real thing
+    size_t kept = 0;
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+        if (pending[i].due <= nowMs)
+        {
+            socket.SendTo(toPort, pending[i].data.data(), pending[i].data.size());
+        }
+        else
+        {
+            if (kept != i)
+            {
+                pending[kept] = std::move(pending[i]);
+            }
+            ++kept;
+        }
+    }
+    pending.resize(kept);
+}
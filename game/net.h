@@ -0,0 +1,62 @@
+// Minimal UDP over the loopback interface, for trying netplay on one
+// machine. LaggyLink sits on the sending side and holds packets back to
+// fake a real network's latency and jitter.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rng.h"
+
+class UdpSocket
+{
+public:
+    UdpSocket() = default;
+    ~UdpSocket();
+
+    UdpSocket(UdpSocket const &) = delete;
+    UdpSocket &operator=(UdpSocket const &) = delete;
+
+    // Bind to 127.0.0.1:port (0 picks a free port) in non-blocking mode.
+    // False (and prints why) on failure.
+    bool Open(uint16_t port = 0);
+    void Close();
+
+    uint16_t Port() const { return port; }
+
+    bool SendTo(uint16_t toPort, void const *data, size_t size);
+
+    // Size of the next waiting datagram, or -1 if there is none
+    int Receive(void *buffer, size_t size);
+
+private:
+    intptr_t handle = -1;
+    uint16_t port = 0;
+};
+
+class LaggyLink
+{
+public:
+    // Each packet is delayed by rtt / 2 plus a uniform +-jitter (all ms)
+    LaggyLink(UdpSocket &socket, uint16_t toPort, float rttMs, float jitterMs, uint64_t seed);
+
+    void Send(double nowMs, uint8_t const *data, size_t size);
+
+    // Put everything that's due by nowMs on the wire
+    void Flush(double nowMs);
+
+private:
+    struct Pending
+    {
+        double due;
+        std::vector<uint8_t> data;
+    };
+
+    UdpSocket &socket;
+    uint16_t toPort;
+    float oneWayMs;
+    float jitterMs;
+    Rng rng;
+    std::vector<Pending> pending;
+};
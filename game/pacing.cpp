@@ -0,0 +1,151 @@
+#include "pacing.h"
+
+#include <cmath>
+#include <ostream>
+#include <thread>
+
+using namespace std;
+
+// Wake margin limits: never trust a sleep to land closer than this, and
+// never spin longer than that (a coarse 15.6 ms Windows tick would need
+// more, but SDL asks for 1 ms timers on init)
+static const double Min_Wake_Margin_Ms = 0.2;
+static const double Max_Wake_Margin_Ms = 2.0;
+
+// AdaptiveVSync goes back to vsync after this many frames that would
+// have fit in 75% of a refresh
+static const int VSync_Return_Frames = 120;
+
+FramePacer::FramePacer(PacingMode mode, double targetFps)
+    : mode(mode),
+      intervalMs(targetFps > 0.0 ? 1000.0 / targetFps : 0.0),
+      vsync(mode == PacingMode::VSync || mode == PacingMode::AdaptiveVSync)
+{
+}
+
+void FramePacer::WaitUntil(Clock::time_point until)
+{
+    auto now = Clock::now();
+    double remainingMs = chrono::duration<double, milli>(until - now).count();
+
+    if (remainingMs > wakeMarginMs)
+    {
+        auto wake = until - chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(wakeMarginMs));
+        this_thread::sleep_until(wake);
+
+        // Late wakeups widen the margin quickly, early ones shrink it
+        // slowly; one scheduler hiccup shouldn't mean spinning for seconds
+        double lateMs = chrono::duration<double, milli>(Clock::now() - wake).count();
+        double wanted = lateMs * 1.25 + Min_Wake_Margin_Ms;
+        double rate = wanted > wakeMarginMs ? 0.25 : 0.02;
+        wakeMarginMs += (wanted - wakeMarginMs) * rate;
+        wakeMarginMs = fmin(fmax(wakeMarginMs, Min_Wake_Margin_Ms), Max_Wake_Margin_Ms);
+    }
+
+    while (Clock::now() < until)
+    {
+        this_thread::yield();
+    }
+}
+
+void FramePacer::AdaptVSync(double busyMs)
+{
+    if (vsync)
+    {
+        // Waited past a whole extra refresh: tear instead from now on
+        if (busyMs > 1.5 * intervalMs)
+        {
+            vsync = false;
+            fastFrames = 0;
+        }
+    }
+    else if (busyMs < 0.75 * intervalMs)
+    {
+        if (++fastFrames >= VSync_Return_Frames)
+        {
+            vsync = true;
+        }
+    }
+    else
+    {
+        fastFrames = 0;
+    }
+}
+
+void FramePacer::EndFrame()
+{
+    auto now = Clock::now();
+    if (!started)
+    {
+        started = true;
+        lastEnd = now;
+        deadline = now;
+        return;
+    }
+
+    double busyMs = chrono::duration<double, milli>(now - lastEnd).count();
+
+    if (mode == PacingMode::AdaptiveVSync && intervalMs > 0.0)
+    {
+        AdaptVSync(busyMs);
+    }
+
+    // Paced on the CPU: a set frame rate, or adaptive vsync while it's off
+    bool cpuPaced = mode == PacingMode::TargetFps || (mode == PacingMode::AdaptiveVSync && !vsync);
+    if (cpuPaced && intervalMs > 0.0)
+    {
+        // Deadlines step by the interval so rounding never drifts; a frame
+        // that's more than one interval late starts a new schedule
+        auto interval = chrono::duration_cast<Clock::duration>(chrono::duration<double, milli>(intervalMs));
+        deadline += interval;
+        if (deadline < now - interval)
+        {
+            deadline = now;
+        }
+        WaitUntil(deadline);
+        now = Clock::now();
+    }
+
+    double frameMs = chrono::duration<double, milli>(now - lastEnd).count();
+    lastEnd = now;
+
+    frames++;
+    double delta = frameMs - mean;
+    mean += delta / frames;
+    m2 += delta * (frameMs - mean);
+    minMs = frames == 1 || frameMs < minMs ? frameMs : minMs;
+    maxMs = frameMs > maxMs ? frameMs : maxMs;
+    if (mode != PacingMode::Unlimited && intervalMs > 0.0 && frameMs > 1.5 * intervalMs)
+    {
+        missed++;
+    }
+}
+
+FrameStats FramePacer::Stats() const
+{
+    FrameStats stats;
+    stats.frames = frames;
+    stats.meanMs = mean;
+    stats.jitterMs = frames > 1 ? sqrt(m2 / (frames - 1)) : 0.0;
+    stats.minMs = minMs;
+    stats.maxMs = maxMs;
+    stats.missed = missed;
+    return stats;
+}
+
+void FramePacer::Report(ostream &out) const
+{
+    static const char *const names[] = {"unlimited", "vsync", "fps", "adaptive"};
+    FrameStats stats = Stats();
+
+    out << "pacing:         " << names[static_cast<int>(mode)];
+    if (mode != PacingMode::Unlimited && intervalMs > 0.0)
+    {
+        out << " (" << 1000.0 / intervalMs << " Hz)";
+    }
+    out << '\n'
+        << "frames:         " << stats.frames << '\n'
+        << "frame time:     " << stats.meanMs << " ms mean, " << stats.jitterMs << " ms jitter, "
+        << stats.minMs << " - " << stats.maxMs << " ms\n"
+        << "missed:         " << stats.missed << " frames\n";
+}
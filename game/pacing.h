@@ -0,0 +1,87 @@
+// Frame pacing: how long the main loop waits between frames, so drawing
+// the table doesn't take a whole core.
+//
+// VSync lets the present block until the display's next refresh.
+// TargetFps sleeps until shortly before each deadline and spins the rest
+// of the way, which is exact to a few microseconds at a tiny CPU cost;
+// how early to wake is learned from how late sleeps have come back.
+// AdaptiveVSync is vsync while frames keep up and tearing instead of
+// waiting a whole extra refresh when one runs late; its off-vsync frames
+// are paced at the refresh rate.
+//
+// Either way the pacer measures the time between frames and reports the
+// average, the jitter (standard deviation) and the deadlines missed.
+#pragma once
+
+#include <chrono>
+#include <iosfwd>
+
+enum class PacingMode
+{
+    Unlimited, // As fast as the loop goes
+    VSync,
+    TargetFps,
+    AdaptiveVSync,
+};
+
+struct FrameStats
+{
+    long long frames = 0;
+    double meanMs = 0.0;
+    double jitterMs = 0.0; // Standard deviation of the frame time
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    long long missed = 0; // Frames longer than 1.5 target intervals
+};
+
+class FramePacer
+{
+public:
+    // targetFps is the frame rate for TargetFps and the refresh rate for
+    // the vsync modes (used for pacing off-vsync frames and for counting
+    // misses)
+    FramePacer(PacingMode mode, double targetFps);
+
+    PacingMode Mode() const { return mode; }
+
+    // Call right after presenting. Waits out the rest of the frame when
+    // this mode paces on the CPU.
+    void EndFrame();
+
+    // Whether the renderer should wait for vsync right now; changes over
+    // time only in AdaptiveVSync
+    bool WantVSync() const { return vsync; }
+
+    FrameStats Stats() const;
+    void Report(std::ostream &out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Sleep then spin until deadline
+    void WaitUntil(Clock::time_point deadline);
+    void AdaptVSync(double busyMs);
+
+    PacingMode mode;
+    double intervalMs;
+    bool vsync;
+    bool started = false;
+
+    Clock::time_point lastEnd;
+    Clock::time_point deadline;
+
+    // How much earlier than the deadline to wake up, learned from how late
+    // sleeps have been
+    double wakeMarginMs = 1.0;
+
+    // AdaptiveVSync: frames in a row that would have fit
+    int fastFrames = 0;
+
+    // Running mean and variance (Welford)
+    long long frames = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    long long missed = 0;
+};
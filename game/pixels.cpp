@@ -0,0 +1,207 @@
+#include "pixels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "collision_simd.h"
+
+using namespace std;
+
+// Score text height in main() (the TTF is opened at 40)
+static const float Score_Height = 40.0f;
+
+const uint16_t Digit_Font[10] = {
+    0x7B6F, // 0
+    0x749A, // 1
+    0x73E7, // 2
+    0x79E7, // 3
+    0x49ED, // 4
+    0x79CF, // 5
+    0x7BCF, // 6
+    0x4927, // 7
+    0x7BEF, // 8
+    0x79EF, // 9
+};
+
+PixelRenderer::PixelRenderer(int width, int height)
+    : width(width), height(height), canvasWidth(2 * width), canvasHeight(2 * height)
+{
+    scaleX = static_cast<float>(canvasWidth) / WIDTH;
+    scaleY = static_cast<float>(canvasHeight) / HEIGHT;
+    canvas.resize(static_cast<size_t>(canvasWidth) * canvasHeight);
+}
+
+void PixelRenderer::FillRect(float x, float y, float w, float h)
+{
+    int left = static_cast<int>(floorf(x * scaleX));
+    int top = static_cast<int>(floorf(y * scaleY));
+    int right = max(left + 1, static_cast<int>(ceilf((x + w) * scaleX)));
+    int bottom = max(top + 1, static_cast<int>(ceilf((y + h) * scaleY)));
+
+    left = max(left, 0);
+    top = max(top, 0);
+    right = min(right, canvasWidth);
+    bottom = min(bottom, canvasHeight);
+
+    for (int row = top; row < bottom; row++)
+    {
+        memset(canvas.data() + static_cast<size_t>(row) * canvasWidth + left, Pixel_Foreground, max(right - left, 0));
+    }
+}
+
+void PixelRenderer::DrawNumber(int value, float x, float y)
+{
+    // Digits left to right, one empty column between them
+    char digits[12];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>(value % 10);
+        value /= 10;
+    } while (value > 0 && count < 12);
+
+    float cell = Score_Height / Digit_Rows;
+
+    for (int d = count - 1; d >= 0; d--)
+    {
+        uint16_t glyph = Digit_Font[static_cast<int>(digits[d])];
+        for (int row = 0; row < Digit_Rows; row++)
+        {
+            for (int column = 0; column < Digit_Columns; column++)
+            {
+                if (glyph & (1 << (row * Digit_Columns + column)))
+                {
+                    FillRect(x + column * cell, y + row * cell, cell, cell);
+                }
+            }
+        }
+        x += (Digit_Columns + 1) * cell;
+    }
+}
+
+void PixelRenderer::Render(Match const &match, uint8_t *out)
+{
+    fill(canvas.begin(), canvas.end(), Pixel_Background);
+
+    // Center line: main() skips every fifth point. Gaps thinner than a
+    // canvas pixel close up, which is what a real downscale would do too.
+    for (int i = 1; i < HEIGHT; i += 5)
+    {
+        FillRect(WIDTH / 2.0f, static_cast<float>(i), 1.0f, static_cast<float>(min(4, HEIGHT - i)));
+    }
+
+    FillRect(match.ball.position.x, match.ball.position.y, Ball_Width, Ball_Height);
+    FillRect(match.paddle1.position.x, match.paddle1.position.y, Paddle_Width, Paddle_Height);
+    FillRect(match.paddle2.position.x, match.paddle2.position.y, Paddle_Width, Paddle_Height);
+
+    // Where main() puts the score text
+    DrawNumber(match.playerOneScore, WIDTH / 4.0f, 20.0f);
+    DrawNumber(match.playerTwoScore, WIDTH * 3 / 4, 20.0f);
+
+    Downsample2x2(canvas.data(), canvasWidth, canvasHeight, out);
+}
+
+void Downsample2x2Scalar(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst)
+{
+    int dstWidth = srcWidth / 2;
+
+    for (int row = 0; row < srcHeight / 2; row++)
+    {
+        uint8_t const *a = src + static_cast<size_t>(2 * row) * srcWidth;
+        uint8_t const *b = a + srcWidth;
+        uint8_t *out = dst + static_cast<size_t>(row) * dstWidth;
+
+        for (int i = 0; i < dstWidth; i++)
+        {
+            int left = (a[2 * i] + b[2 * i] + 1) >> 1;
+            int right = (a[2 * i + 1] + b[2 * i + 1] + 1) >> 1;
+            out[i] = static_cast<uint8_t>((left + right + 1) >> 1);
+        }
+    }
+}
+
+#ifdef PONG_X86
+
+void Downsample2x2SSE2(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst)
+{
+    int dstWidth = srcWidth / 2;
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i one = _mm_set1_epi16(1);
+
+    for (int row = 0; row < srcHeight / 2; row++)
+    {
+        uint8_t const *a = src + static_cast<size_t>(2 * row) * srcWidth;
+        uint8_t const *b = a + srcWidth;
+        uint8_t *out = dst + static_cast<size_t>(row) * dstWidth;
+
+        // 32 source columns into 16 output pixels
+        int i = 0;
+        for (; i + 16 <= dstWidth; i += 16)
+        {
+            __m128i rows0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a + 2 * i)),
+                                         _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + 2 * i)));
+            __m128i rows1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a + 2 * i + 16)),
+                                         _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + 2 * i + 16)));
+
+            // Even + odd column of every pair, as 16-bit sums
+            __m128i sum0 = _mm_add_epi16(_mm_and_si128(rows0, lowBytes), _mm_srli_epi16(rows0, 8));
+            __m128i sum1 = _mm_add_epi16(_mm_and_si128(rows1, lowBytes), _mm_srli_epi16(rows1, 8));
+            sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, one), 1);
+            sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, one), 1);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(sum0, sum1));
+        }
+
+        for (; i < dstWidth; i++)
+        {
+            int left = (a[2 * i] + b[2 * i] + 1) >> 1;
+            int right = (a[2 * i + 1] + b[2 * i + 1] + 1) >> 1;
+            out[i] = static_cast<uint8_t>((left + right + 1) >> 1);
+        }
+    }
+}
+
+#else
+
+void Downsample2x2SSE2(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst)
+{
+    Downsample2x2Scalar(src, srcWidth, srcHeight, dst);
+}
+
+#endif
+
+void Downsample2x2(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst)
+{
+    Downsample2x2SSE2(src, srcWidth, srcHeight, dst);
+}
+
+FrameStack::FrameStack(int frames, int frameBytes)
+    : frames(frames), frameBytes(frameBytes), ring(static_cast<size_t>(frames) * frameBytes)
+{
+}
+
+uint8_t *FrameStack::Next()
+{
+    newest = (newest + 1) % frames;
+    return ring.data() + static_cast<size_t>(newest) * frameBytes;
+}
+
+void FrameStack::Write(uint8_t *out) const
+{
+    for (int i = 1; i <= frames; i++)
+    {
+        int slot = (newest + i) % frames;
+        memcpy(out, ring.data() + static_cast<size_t>(slot) * frameBytes, frameBytes);
+        out += frameBytes;
+    }
+}
+
+void FrameStack::Fill(uint8_t const *frame)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        memcpy(ring.data() + static_cast<size_t>(i) * frameBytes, frame, frameBytes);
+    }
+    newest = frames - 1;
+}
@@ -0,0 +1,86 @@
+// Pixel observations for training: the scene main() draws (background,
+// dashed center line, ball, paddles, scores) in grayscale at a small size
+// like 84x84 or 160x210, on the CPU, with no window, GPU or SDL.
+//
+// The scene is rasterized at twice the output size and then box-filtered
+// down 2x2 with SSE2. At these sizes a paddle is about one output pixel
+// wide and the center line much less, so drawing straight at the output
+// size would make them flicker in and out as they move; this way they
+// keep showing up as partly lit pixels.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pong.h"
+
+// main()'s colors as 8-bit luma (BT.601)
+constexpr uint8_t Luma(int r, int g, int b)
+{
+    return static_cast<uint8_t>((299 * r + 587 * g + 114 * b + 500) / 1000);
+}
+
+const uint8_t Pixel_Background = Luma(0xFF, 0x80, 0xFF);
+const uint8_t Pixel_Foreground = Luma(0xFF, 0xFF, 0x00);
+
+// 3x5 digits: bit (row * 3 + column) is lit, row 0 at the top
+const int Digit_Columns = 3;
+const int Digit_Rows = 5;
+extern const uint16_t Digit_Font[10];
+
+class PixelRenderer
+{
+public:
+    // Output frame size, in pixels. Anything from a few pixels up works;
+    // 84x84 and 160x210 are the usual ones.
+    PixelRenderer(int width, int height);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    // Width() * Height() bytes, row after row
+    void Render(Match const &match, uint8_t *out);
+
+private:
+    // A rectangle in field coordinates, snapped out to whole canvas pixels
+    // (never less than one, so nothing thin disappears)
+    void FillRect(float x, float y, float w, float h);
+    void DrawNumber(int value, float x, float y);
+
+    int width;
+    int height;
+    int canvasWidth;
+    int canvasHeight;
+    float scaleX;
+    float scaleY;
+    std::vector<uint8_t> canvas;
+};
+
+// Halve a grayscale image: every output pixel is the rounded average of a
+// 2x2 block (rows averaged first). Scalar and SSE2 give the same bytes.
+void Downsample2x2(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst);
+void Downsample2x2Scalar(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst);
+void Downsample2x2SSE2(uint8_t const *src, int srcWidth, int srcHeight, uint8_t *dst);
+
+// The last few frames of one match, for agents that need to see motion.
+// Frames go into a ring, so pushing one copies nothing.
+class FrameStack
+{
+public:
+    FrameStack(int frames, int frameBytes);
+
+    // Slot to render the newest frame into; it replaces the oldest
+    uint8_t *Next();
+
+    // frames * frameBytes bytes, oldest frame first
+    void Write(uint8_t *out) const;
+
+    // Start over with every slot holding this frame
+    void Fill(uint8_t const *frame);
+
+private:
+    int frames;
+    int frameBytes;
+    int newest = -1;
+    std::vector<uint8_t> ring;
+};
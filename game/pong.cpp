@@ -0,0 +1,438 @@
+#include "pong.h"
+
+#include "profile.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Paddle and wall bounces handled within one tick before giving up on the
+// rest of the step
+static const int Max_Bounces_Per_Tick = 4;
+
+void Ball::update(float dt)
+{
+    previousPosition = position;
+    position += velocity * dt;
+}
+
+template <typename Rules>
+void Ball::CollisionWithPaddle(Contact const &contact, Rules const &rules)
+{
+    position.x += contact.penetration;
+    velocity.x = -velocity.x;
+
+    if (contact.type == CollisionType::Top)
+    {
+        velocity.y = -0.75f * rules.ballSpeed;
+    }
+    else if (contact.type == CollisionType::Bottom)
+    {
+        velocity.y = 0.75f * rules.ballSpeed;
+    }
+}
+
+template <typename Rules>
+void Ball::CollideWithWall(Contact const &contact, Rng &rng, Rules const &rules)
+{
+    if ((contact.type == CollisionType::Top) || (contact.type == CollisionType::Bottom))
+    {
+        position.y += contact.penetration;
+        velocity.y = -velocity.y;
+    }
+    else if (contact.type == CollisionType::Left || contact.type == CollisionType::Right)
+    {
+        // Reset ball position to the center
+        position.x = rules.width / 2.0f;
+        position.y = rules.height / 2.0f;
+
+        // Don't interpolate across the teleport
+        previousPosition = position;
+
+        // Randomize Y-axis velocity after reset
+        velocity.x = (contact.type == CollisionType::Left) ? rules.ballSpeed : -rules.ballSpeed;
+        velocity.y = ((rng.NextU32() % 2) == 0 ? 1 : -1) * (0.5f + rng.NextFloat() * 0.5f) * rules.ballSpeed;
+    }
+}
+
+template <typename Rules>
+void Paddle::update(float dt, Rules const &rules)
+{
+    previousPosition = position;
+    position += velocity * dt;
+
+    if (position.y < 0)
+    {
+        // Keeps the paddle at the top of the screen
+        position.y = 0;
+    }
+    else if (position.y > (rules.height - rules.paddleHeight))
+    {
+        // Keeps the paddle at the bottom of the screen
+        position.y = rules.height - rules.paddleHeight;
+    }
+}
+
+template <typename Rules>
+Contact chekcPaddleCollision(Ball const &ball, Paddle const &paddle, Rules const &rules)
+{
+    float ballLeft = ball.position.x;
+    float ballRight = ball.position.x + rules.ballWidth;
+    float ballTop = ball.position.y;
+    float ballBottom = ball.position.y + rules.ballHeight;
+
+    float paddleLeft = paddle.position.x;
+    float paddleRight = paddle.position.x + rules.paddleWidth;
+    float paddleTop = paddle.position.y;
+    float paddleBottom = paddle.position.y + rules.paddleHeight;
+
+    Contact contact{};
+
+    if (ballLeft >= paddleRight)
+    {
+        return contact;
+    }
+    if (ballRight <= paddleLeft)
+    {
+        return contact;
+    }
+
+    if (ballTop >= paddleBottom)
+    {
+        return contact;
+    }
+    if (ballBottom <= paddleTop)
+    {
+        return contact;
+    }
+
+    if (ball.velocity.x < 0)
+    {
+        // Left paddle
+        contact.penetration = paddleRight - ballLeft;
+    }
+    else if (ball.velocity.x > 0)
+    {
+        // Right paddle
+        contact.penetration = paddleLeft - ballRight;
+    }
+
+    contact.type = PaddleZone(ballBottom, paddle, rules);
+
+    return contact;
+}
+
+template <typename Rules>
+CollisionType PaddleZone(float ballBottom, Paddle const &paddle, Rules const &rules)
+{
+    float paddleTop = paddle.position.y;
+    float paddleBottom = paddle.position.y + rules.paddleHeight;
+
+    float paddleRangeUpper = paddleBottom - (2.0f * rules.paddleHeight / 3.0f);
+    float paddleRangerMiddle = paddleBottom - (rules.paddleHeight / 3.0f);
+
+    if ((ballBottom > paddleTop) && (ballBottom < paddleRangeUpper))
+    {
+        return CollisionType::Top;
+    }
+    else if ((ballBottom > paddleRangeUpper) && (ballBottom < paddleRangerMiddle))
+    {
+        return CollisionType::Middle;
+    }
+
+    return CollisionType::Bottom;
+}
+
+// When a span [position, position + size) moving at velocity overlaps the
+// still span [boxPosition, boxPosition + boxSize). False if it never does.
+static bool SweepAxis(float position, float size, float velocity,
+                      float boxPosition, float boxSize, float &enter, float &exit)
+{
+    if (velocity == 0.0f)
+    {
+        if (position >= boxPosition + boxSize || position + size <= boxPosition)
+        {
+            return false;
+        }
+
+        enter = -INFINITY;
+        exit = INFINITY;
+        return true;
+    }
+
+    float nearTime = (boxPosition - (position + size)) / velocity;
+    float farTime = (boxPosition + boxSize - position) / velocity;
+
+    enter = min(nearTime, farTime);
+    exit = max(nearTime, farTime);
+    return true;
+}
+
+template <typename Rules>
+float SweepPaddle(Ball const &ball, Paddle const &paddle, float maxTime, Rules const &rules)
+{
+    float enterX, exitX, enterY, exitY;
+
+    if (!SweepAxis(ball.position.x, rules.ballWidth, ball.velocity.x, paddle.position.x, rules.paddleWidth, enterX, exitX) ||
+        !SweepAxis(ball.position.y, rules.ballHeight, ball.velocity.y, paddle.position.y, rules.paddleHeight, enterY, exitY))
+    {
+        return -1.0f;
+    }
+
+    // Touching happens once both axes overlap, and only counts if they
+    // still overlap after that (not just grazing a corner)
+    float enter = max(enterX, enterY);
+    float exit = min(exitX, exitY);
+
+    if (enter >= exit || enter < 0.0f || enter > maxTime)
+    {
+        return -1.0f;
+    }
+
+    return enter;
+}
+
+template <typename Rules>
+Contact CheckWallCollisions(Ball const &ball, Rules const &rules)
+{
+    float ballLeft = ball.position.x;
+    float ballRight = ball.position.x + rules.ballWidth;
+    float ballTop = ball.position.y;
+    float ballBottom = ball.position.y + rules.ballHeight;
+
+    Contact contact{};
+
+    if (ballLeft < 0.0f)
+    {
+        contact.type = CollisionType::Left;
+    }
+    else if (ballRight > rules.width)
+    {
+        contact.type = CollisionType::Right;
+    }
+    else if (ballTop < 0.0f)
+    {
+        contact.type = CollisionType::Top;
+        contact.penetration = -ballTop;
+    }
+    else if (ballBottom > rules.height)
+    {
+        contact.type = CollisionType::Bottom;
+        contact.penetration = rules.height - ballBottom;
+    }
+
+    return contact;
+}
+
+template <typename Rules>
+BasicMatch<Rules>::BasicMatch(uint64_t seed, Rules const &rules)
+    : rules(rules),
+      ball(Vec2(rules.width / 2.0f - rules.ballWidth / 2.0f, rules.height / 2.0f - rules.ballHeight / 2.0f),
+           Vec2(rules.ballSpeed, 0.0f)),
+      paddle1(Vec2(50.0f, rules.height / 2.0f), Vec2(0.0f, 0.0f)),
+      paddle2(Vec2(rules.width - 50.0f, rules.height / 2.0f), Vec2(0.0f, 0.0f)),
+      rng(seed)
+{
+}
+
+template <typename Rules>
+void BasicMatch<Rules>::SetButtons(bool const buttons[4])
+{
+    if (buttons[Buttons::PaddleOneUP])
+    {
+        paddle1.velocity.y = -rules.paddleSpeed;
+    }
+    else if (buttons[Buttons::PaddleOneDown])
+    {
+        paddle1.velocity.y = rules.paddleSpeed;
+    }
+    else
+    {
+        paddle1.velocity.y = 0.0f;
+    }
+
+    if (buttons[Buttons::PaddleTwoUp])
+    {
+        paddle2.velocity.y = -rules.paddleSpeed;
+    }
+    else if (buttons[Buttons::PaddleTwoDown])
+    {
+        paddle2.velocity.y = rules.paddleSpeed;
+    }
+    else
+    {
+        paddle2.velocity.y = 0.0f;
+    }
+}
+
+template <typename Rules>
+void BasicMatch<Rules>::Save(GameState &state) const
+{
+    state.ballX = ball.position.x;
+    state.ballY = ball.position.y;
+    state.ballVX = ball.velocity.x;
+    state.ballVY = ball.velocity.y;
+    state.paddleOneY = paddle1.position.y;
+    state.paddleOneVY = paddle1.velocity.y;
+    state.paddleTwoY = paddle2.position.y;
+    state.paddleTwoVY = paddle2.velocity.y;
+    state.playerOneScore = playerOneScore;
+    state.playerTwoScore = playerTwoScore;
+    state.rngState = rng.state;
+}
+
+template <typename Rules>
+void BasicMatch<Rules>::Restore(GameState const &state)
+{
+    ball.position = Vec2(state.ballX, state.ballY);
+    ball.velocity = Vec2(state.ballVX, state.ballVY);
+    paddle1.position.y = state.paddleOneY;
+    paddle1.velocity.y = state.paddleOneVY;
+    paddle2.position.y = state.paddleTwoY;
+    paddle2.velocity.y = state.paddleTwoVY;
+    playerOneScore = state.playerOneScore;
+    playerTwoScore = state.playerTwoScore;
+    rng.state = state.rngState;
+
+    // Nothing to interpolate from after a jump
+    ball.previousPosition = ball.position;
+    paddle1.previousPosition = paddle1.position;
+    paddle2.previousPosition = paddle2.position;
+}
+
+template <typename Rules>
+CollisionType BasicMatch<Rules>::Tick(float dt)
+{
+    // Update paddle position
+    PROFILE_START(paddleTimer, Phase_Paddles);
+    paddle1.update(dt, rules);
+    paddle2.update(dt, rules);
+    PROFILE_STOP(paddleTimer);
+
+    PROFILE_START(collisionTimer, Phase_Collision);
+    ball.previousPosition = ball.position;
+
+    // A paddle that moved into the ball pushes it out like before
+    if (Contact contact = chekcPaddleCollision(ball, paddle1, rules);
+        contact.type != CollisionType::None)
+    {
+        ball.CollisionWithPaddle(contact, rules);
+    }
+    else if (contact = chekcPaddleCollision(ball, paddle2, rules);
+             contact.type != CollisionType::None)
+    {
+        ball.CollisionWithPaddle(contact, rules);
+    }
+
+    // Sweep the ball through the step, stopping at each bounce
+    float remaining = dt;
+    Paddle const *lastPaddle = nullptr;
+
+    for (int bounce = 0; bounce < Max_Bounces_Per_Tick && remaining > 0.0f; bounce++)
+    {
+        float hitTime = remaining;
+        Contact contact{};
+        Paddle const *hitPaddle = nullptr;
+
+        for (Paddle const *paddle : {&paddle1, &paddle2})
+        {
+            // Just bounced off it, the ball is sitting on its face
+            if (paddle == lastPaddle)
+            {
+                continue;
+            }
+
+            float time = SweepPaddle(ball, *paddle, hitTime, rules);
+            if (time >= 0.0f)
+            {
+                hitTime = time;
+                hitPaddle = paddle;
+            }
+        }
+
+        if (ball.velocity.y < 0.0f)
+        {
+            float time = -ball.position.y / ball.velocity.y;
+            if (time >= 0.0f && time < hitTime)
+            {
+                hitTime = time;
+                hitPaddle = nullptr;
+                contact.type = CollisionType::Top;
+            }
+        }
+        else if (ball.velocity.y > 0.0f)
+        {
+            float time = (rules.height - rules.ballHeight - ball.position.y) / ball.velocity.y;
+            if (time >= 0.0f && time < hitTime)
+            {
+                hitTime = time;
+                hitPaddle = nullptr;
+                contact.type = CollisionType::Bottom;
+            }
+        }
+
+        if (hitPaddle == nullptr && contact.type == CollisionType::None)
+        {
+            break;
+        }
+
+        // Move to the point of impact and bounce
+        ball.position += ball.velocity * hitTime;
+        remaining -= hitTime;
+
+        if (hitPaddle != nullptr)
+        {
+            contact.type = PaddleZone(ball.position.y + rules.ballHeight, *hitPaddle, rules);
+            contact.penetration = 0.0f;
+            ball.CollisionWithPaddle(contact, rules);
+        }
+        else
+        {
+            // Snap exactly onto the wall
+            contact.penetration = contact.type == CollisionType::Top ? -ball.position.y
+                                                                      : rules.height - (ball.position.y + rules.ballHeight);
+            ball.CollideWithWall(contact, rng, rules);
+        }
+
+        lastPaddle = hitPaddle;
+    }
+    PROFILE_STOP(collisionTimer);
+
+    PROFILE_SCOPE(Phase_Ball);
+    ball.position += ball.velocity * remaining;
+
+    // Goals (and anything the bounce limit let through)
+    if (Contact contact = CheckWallCollisions(ball, rules);
+        contact.type != CollisionType::None)
+    {
+        ball.CollideWithWall(contact, rng, rules);
+
+        if (contact.type == CollisionType::Left)
+        {
+            ++playerTwoScore;
+            return CollisionType::Left;
+        }
+        else if (contact.type == CollisionType::Right)
+        {
+            ++playerOneScore;
+            return CollisionType::Right;
+        }
+    }
+
+    return CollisionType::None;
+}
+
+// The shipped rules, constant-folded, and the runtime ones for experiments
+#define PONG_INSTANTIATE_RULES(Rules)                                                                   \
+    template void Ball::CollisionWithPaddle<Rules>(Contact const &, Rules const &);                     \
+    template void Ball::CollideWithWall<Rules>(Contact const &, Rng &, Rules const &);                  \
+    template void Paddle::update<Rules>(float, Rules const &);                                          \
+    template Contact chekcPaddleCollision<Rules>(Ball const &, Paddle const &, Rules const &);          \
+    template Contact CheckWallCollisions<Rules>(Ball const &, Rules const &);                           \
+    template CollisionType PaddleZone<Rules>(float, Paddle const &, Rules const &);                     \
+    template float SweepPaddle<Rules>(Ball const &, Paddle const &, float, Rules const &);              \
+    template class BasicMatch<Rules>;
+
+PONG_INSTANTIATE_RULES(StandardRules)
+PONG_INSTANTIATE_RULES(RuntimeRules)
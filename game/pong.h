@@ -0,0 +1,153 @@
+// Pong simulation core. Nothing in here may depend on SDL so the same
+// physics can run in the game, in headless tools and on servers.
+//
+// Everything that depends on the rules is a template on them (rules.h),
+// defaulting to StandardRules. Both StandardRules and RuntimeRules are
+// instantiated in pong.cpp.
+#pragma once
+
+#include <cstdint>
+
+#include "rng.h"
+#include "rules.h"
+#include "vec2.h"
+
+// Fixed simulation rate, independent of the display refresh rate
+const int Tick_Rate = 120;
+
+enum Buttons
+{
+    PaddleOneUP = 0,
+    PaddleOneDown,
+    PaddleTwoUp,
+    PaddleTwoDown,
+};
+
+// The four Buttons packed into the low bits of a byte (bit n = Buttons n)
+inline unsigned char PackButtons(bool const buttons[4])
+{
+    return static_cast<unsigned char>(buttons[0] | (buttons[1] << 1) | (buttons[2] << 2) | (buttons[3] << 3));
+}
+
+inline void UnpackButtons(unsigned char mask, bool buttons[4])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        buttons[i] = (mask >> i) & 1;
+    }
+}
+
+enum class CollisionType
+{
+    None,
+    Top,
+    Middle,
+    Bottom,
+    Left,
+    Right
+};
+
+struct Contact
+{
+    CollisionType type;
+    float penetration;
+};
+
+class Ball
+{
+public:
+    Ball(Vec2 position, Vec2 velocity)
+        : position(position), previousPosition(position), velocity(velocity) {}
+
+    void update(float dt);
+    template <typename Rules = StandardRules>
+    void CollisionWithPaddle(Contact const &contact, Rules const &rules = Rules());
+    // Top/Bottom bounce; Left/Right re-serve from the center using rng
+    template <typename Rules = StandardRules>
+    void CollideWithWall(Contact const &contact, Rng &rng, Rules const &rules = Rules());
+
+    Vec2 position;
+    Vec2 previousPosition;
+    Vec2 velocity;
+};
+
+class Paddle
+{
+public:
+    Paddle(Vec2 position, Vec2 velocity)
+        : position(position), previousPosition(position), velocity(velocity) {}
+
+    // Update paddle position
+    template <typename Rules = StandardRules>
+    void update(float dt, Rules const &rules = Rules());
+
+    Vec2 position;
+    Vec2 previousPosition;
+    Vec2 velocity;
+};
+
+// Ball and Paddle Collision
+template <typename Rules = StandardRules>
+Contact chekcPaddleCollision(Ball const &ball, Paddle const &paddle, Rules const &rules = Rules());
+template <typename Rules = StandardRules>
+Contact CheckWallCollisions(Ball const &ball, Rules const &rules = Rules());
+
+// Which third of the paddle a ball with this bottom edge hits
+template <typename Rules = StandardRules>
+CollisionType PaddleZone(float ballBottom, Paddle const &paddle, Rules const &rules = Rules());
+
+// Swept test: the time in [0, maxTime] at which the moving ball first
+// touches the (still) paddle, or a negative value if it doesn't. A ball
+// that already overlaps the paddle isn't a sweep hit, chekcPaddleCollision
+// handles that case.
+template <typename Rules = StandardRules>
+float SweepPaddle(Ball const &ball, Paddle const &paddle, float maxTime, Rules const &rules = Rules());
+
+// Everything needed to carry a Match on from where it was, in one flat
+// block that fits a cache line. Paddle x and the previous-tick positions
+// used for drawing aren't part of it.
+struct GameState
+{
+    float ballX, ballY, ballVX, ballVY;
+    float paddleOneY, paddleOneVY, paddleTwoY, paddleTwoVY;
+    int32_t playerOneScore, playerTwoScore;
+    uint64_t rngState;
+};
+
+static_assert(sizeof(GameState) <= 64, "GameState should stay within one cache line");
+
+// One game of Pong: a ball, two paddles and the score.
+template <typename Rules>
+class BasicMatch
+{
+public:
+    explicit BasicMatch(uint64_t seed = 1, Rules const &rules = Rules());
+
+    // Map the four held buttons onto paddle velocities
+    void SetButtons(bool const buttons[4]);
+
+    // Advance one fixed tick. The ball is swept through the whole step and
+    // bounces at the exact time of impact, so any dt is safe. Returns
+    // Left/Right when a point was scored on that side, None otherwise.
+    CollisionType Tick(float dt);
+
+    // Snapshot into (or rewind from) caller-owned storage. No allocation,
+    // just a few dozen bytes copied.
+    void Save(GameState &state) const;
+    void Restore(GameState const &state);
+
+    Rules rules;
+
+    Ball ball;
+    Paddle paddle1;
+    Paddle paddle2;
+
+    int playerOneScore = 0;
+    int playerTwoScore = 0;
+
+    // Serve direction after every point
+    Rng rng;
+};
+
+using Match = BasicMatch<StandardRules>;
+using RuntimeMatch = BasicMatch<RuntimeRules>;
@@ -0,0 +1,207 @@
+#include "profile.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+const char *const Phase_Names[Phase_Count] = {
+    "frame", "events", "input", "paddles", "ball", "collision", "clear", "draw", "present",
+};
+
+static Histogram histograms[Phase_Count];
+
+static const int Sub_Half = 1 << (Histogram_Sub_Bits - 1);
+
+// Values below 2^Sub_Bits get a bucket each; above that, shift until the
+// value has Sub_Bits bits left and bucket on (shift, those bits)
+int Histogram::Bucket(uint64_t value)
+{
+    if (value < (1u << Histogram_Sub_Bits))
+    {
+        return static_cast<int>(value);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    int highest = 63 - __builtin_clzll(value);
+#else
+    int highest = 0;
+    while (value >> (highest + 1))
+    {
+        highest++;
+    }
+#endif
+    int shift = highest - (Histogram_Sub_Bits - 1);
+    return shift * Sub_Half + static_cast<int>(value >> shift);
+}
+
+uint64_t Histogram::BucketTop(int bucket)
+{
+    if (bucket < (1 << Histogram_Sub_Bits))
+    {
+        return static_cast<uint64_t>(bucket);
+    }
+
+    int shift = bucket / Sub_Half - 1;
+    uint64_t mantissa = static_cast<uint64_t>(bucket - shift * Sub_Half);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void Histogram::Record(uint64_t nanoseconds)
+{
+    counts[Bucket(nanoseconds)].fetch_add(1, memory_order_relaxed);
+    total.fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(nanoseconds, memory_order_relaxed);
+
+    uint64_t seen = max.load(memory_order_relaxed);
+    while (nanoseconds > seen && !max.compare_exchange_weak(seen, nanoseconds, memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t Histogram::Count() const
+{
+    return total.load(memory_order_relaxed);
+}
+
+double Histogram::MeanNs() const
+{
+    uint64_t count = Count();
+    return count == 0 ? 0.0 : static_cast<double>(sum.load(memory_order_relaxed)) / count;
+}
+
+uint64_t Histogram::Percentile(double fraction) const
+{
+    uint64_t count = Count();
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // The rank'th smallest sample, counting from 1
+    uint64_t rank = static_cast<uint64_t>(fraction * count + 0.999999);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < Histogram_Buckets; bucket++)
+    {
+        seen += counts[bucket].load(memory_order_relaxed);
+        if (seen >= rank)
+        {
+            uint64_t top = BucketTop(bucket);
+            return top < Max() ? top : Max();
+        }
+    }
+    return Max();
+}
+
+void Histogram::Reset()
+{
+    for (auto &count : counts)
+    {
+        count.store(0, memory_order_relaxed);
+    }
+    total.store(0, memory_order_relaxed);
+    sum.store(0, memory_order_relaxed);
+    max.store(0, memory_order_relaxed);
+}
+
+Histogram &PhaseHistogram(Phase phase)
+{
+    return histograms[phase];
+}
+
+void ResetProfile()
+{
+    for (Histogram &histogram : histograms)
+    {
+        histogram.Reset();
+    }
+}
+
+static double Micros(uint64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1000.0;
+}
+
+void PrintProfile(ostream &out)
+{
+    out << left << setw(12) << "phase" << right << setw(12) << "count" << setw(12) << "mean us"
+        << setw(12) << "p50 us" << setw(12) << "p99 us" << setw(12) << "p99.9 us" << setw(12) << "max us" << '\n';
+
+    out << fixed << setprecision(2);
+    for (int phase = 0; phase < Phase_Count; phase++)
+    {
+        Histogram const &histogram = histograms[phase];
+        if (histogram.Count() == 0)
+        {
+            continue;
+        }
+
+        out << left << setw(12) << Phase_Names[phase] << right << setw(12) << histogram.Count()
+            << setw(12) << histogram.MeanNs() / 1000.0
+            << setw(12) << Micros(histogram.Percentile(0.5))
+            << setw(12) << Micros(histogram.Percentile(0.99))
+            << setw(12) << Micros(histogram.Percentile(0.999))
+            << setw(12) << Micros(histogram.Max()) << '\n';
+    }
+    out << defaultfloat;
+}
+
+bool WriteProfile(string const &path)
+{
+    ofstream file(path);
+    if (!file)
+    {
+        cout << "Can't write " << path << '\n';
+        return false;
+    }
+
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    file << fixed << setprecision(3);
+
+    if (json)
+    {
+        file << "{\n  \"unit\": \"us\",\n  \"phases\": {";
+    }
+    else
+    {
+        file << "phase,count,mean_us,p50_us,p99_us,p999_us,max_us\n";
+    }
+
+    bool first = true;
+    for (int phase = 0; phase < Phase_Count; phase++)
+    {
+        Histogram const &histogram = histograms[phase];
+        if (histogram.Count() == 0)
+        {
+            continue;
+        }
+
+        if (json)
+        {
+            file << (first ? "\n" : ",\n") << "    \"" << Phase_Names[phase] << "\": {"
+                 << "\"count\": " << histogram.Count()
+                 << ", \"mean\": " << histogram.MeanNs() / 1000.0
+                 << ", \"p50\": " << Micros(histogram.Percentile(0.5))
+                 << ", \"p99\": " << Micros(histogram.Percentile(0.99))
+                 << ", \"p99.9\": " << Micros(histogram.Percentile(0.999))
+                 << ", \"max\": " << Micros(histogram.Max()) << "}";
+        }
+        else
+        {
+            file << Phase_Names[phase] << ',' << histogram.Count() << ',' << histogram.MeanNs() / 1000.0 << ','
+                 << Micros(histogram.Percentile(0.5)) << ',' << Micros(histogram.Percentile(0.99)) << ','
+                 << Micros(histogram.Percentile(0.999)) << ',' << Micros(histogram.Max()) << '\n';
+        }
+        first = false;
+    }
+
+    if (json)
+    {
+        file << "\n  }\n}\n";
+    }
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,115 @@
+// Per-phase frame timing, for finding where frame spikes come from.
+//
+// Build with -DPONG_PROFILE (make PROFILE=1) and the PROFILE_ macros time
+// the main loop's phases into one histogram each; without it they expand
+// to nothing, so the shipped build pays nothing. The histograms are
+// HDR-style: exact below 128 ns, then 64 buckets per power of two (about
+// 1.5% resolution) up to minutes. Recording is a relaxed atomic add, so
+// any thread can time into them without locks.
+//
+// Phases can nest: Frame holds all the others, and on the software path
+// Draw holds its Clears. Inside Match::Tick the ball is swept through its
+// bounces, so moving it up to the last bounce counts as Collision and
+// Ball is the rest of the step plus goals; in the arena Ball is the
+// integration and Collision everything after the paddle clamp.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+enum Phase
+{
+    Phase_Frame, // One whole main loop iteration
+    Phase_Events,
+    Phase_Input,
+    Phase_Paddles,
+    Phase_Ball,
+    Phase_Collision,
+    Phase_Clear,
+    Phase_Draw,
+    Phase_Present,
+    Phase_Count,
+};
+
+extern const char *const Phase_Names[Phase_Count];
+
+// Sub-buckets per power of two are 2^(Histogram_Sub_Bits - 1)
+const int Histogram_Sub_Bits = 7;
+const int Histogram_Buckets = (64 - Histogram_Sub_Bits + 2) << (Histogram_Sub_Bits - 1);
+
+class Histogram
+{
+public:
+    void Record(uint64_t nanoseconds);
+
+    uint64_t Count() const;
+    uint64_t Max() const { return max.load(std::memory_order_relaxed); }
+    double MeanNs() const;
+
+    // Smallest value at least fraction of the samples are at or below
+    // (as the top of its bucket, never above Max)
+    uint64_t Percentile(double fraction) const;
+
+    void Reset();
+
+private:
+    static int Bucket(uint64_t value);
+    static uint64_t BucketTop(int bucket);
+
+    std::atomic<uint64_t> counts[Histogram_Buckets] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+};
+
+Histogram &PhaseHistogram(Phase phase);
+void ResetProfile();
+
+// p50, p99, p99.9 and max per phase, in microseconds. Phases nothing was
+// recorded for are left out.
+void PrintProfile(std::ostream &out);
+
+// .json gets JSON, anything else CSV
+bool WriteProfile(std::string const &path);
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { Stop(); }
+
+    // Record now instead of at the end of the scope (only the first call counts)
+    void Stop()
+    {
+        if (!stopped)
+        {
+            stopped = true;
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            PhaseHistogram(phase).Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+    bool stopped = false;
+};
+
+#ifdef PONG_PROFILE
+#define PONG_PROFILE_CONCAT2(a, b) a##b
+#define PONG_PROFILE_CONCAT(a, b) PONG_PROFILE_CONCAT2(a, b)
+// Times the rest of the enclosing scope
+#define PROFILE_SCOPE(phase) ScopedTimer PONG_PROFILE_CONCAT(profileTimer, __LINE__)(phase)
+// A named timer, for spans that end before their scope does
+#define PROFILE_START(name, phase) ScopedTimer name(phase)
+#define PROFILE_STOP(name) name.Stop()
+const bool Profiling = true;
+#else
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_START(name, phase) ((void)0)
+#define PROFILE_STOP(name) ((void)0)
+const bool Profiling = false;
+#endif
@@ -0,0 +1,296 @@
+#include "replay.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static const char Replay_Magic[4] = {'P', 'R', 'P', 'L'};
+static const size_t Replay_Header_Size_V1 = 4 + 2 + 2 + 8 + 4 + 4;
+static const size_t Replay_Header_Size_V2 = Replay_Header_Size_V1 + 4 + 4;
+
+ReplayRecorder::ReplayRecorder(uint64_t seed, int tickRate)
+{
+    replay.seed = seed;
+    replay.tickRate = static_cast<uint16_t>(tickRate);
+    replay.keyframeInterval = static_cast<uint32_t>(Replay_Keyframe_Seconds * tickRate);
+}
+
+void ReplayRecorder::Record(uint8_t buttons, Match const &match)
+{
+    if (runLength > 0 && buttons != runButtons)
+    {
+        FlushRun();
+    }
+
+    if (replay.keyframeInterval > 0 && replay.tickCount % replay.keyframeInterval == 0)
+    {
+        // The open run hasn't been written yet, so it starts at the end
+        Keyframe keyframe;
+        match.Save(keyframe.state);
+        keyframe.tick = replay.tickCount;
+        keyframe.runOffset = static_cast<uint32_t>(replay.runs.size());
+        keyframe.runSkip = runLength;
+        replay.keyframes.push_back(keyframe);
+    }
+
+    runButtons = buttons;
+    ++runLength;
+    ++replay.tickCount;
+}
+
+Replay ReplayRecorder::Finish()
+{
+    FlushRun();
+    return replay;
+}
+
+void ReplayRecorder::FlushRun()
+{
+    if (runLength == 0)
+    {
+        return;
+    }
+
+    if (runLength <= 15)
+    {
+        replay.runs.push_back(static_cast<uint8_t>(runButtons | ((runLength - 1) << 4)));
+    }
+    else
+    {
+        replay.runs.push_back(static_cast<uint8_t>(runButtons | 0xF0));
+
+        uint32_t extra = runLength - 16;
+        do
+        {
+            uint8_t byte = extra & 0x7F;
+            extra >>= 7;
+            replay.runs.push_back(extra ? byte | 0x80 : byte);
+        } while (extra);
+    }
+
+    runLength = 0;
+}
+
+ReplayPlayer::ReplayPlayer(uint8_t const *runs, size_t size, uint32_t skip)
+    : runs(runs), end(runs + size)
+{
+    if (skip > 0 && StartRun())
+    {
+        runLeft = runLeft > skip ? runLeft - skip : 0;
+    }
+}
+
+bool ReplayPlayer::StartRun()
+{
+    if (runs == end)
+    {
+        return false;
+    }
+
+    uint8_t byte = *runs++;
+    runButtons = byte & 0x0F;
+    runLeft = (byte >> 4) + 1;
+
+    if (runLeft == 16)
+    {
+        uint64_t extra = 0;
+        int shift = 0;
+        do
+        {
+            if (runs == end || shift > 28)
+            {
+                runLeft = 0;
+                runs = end;
+                return false;
+            }
+            byte = *runs++;
+            extra |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        runLeft += extra;
+    }
+
+    return true;
+}
+
+bool ReplayPlayer::Next(uint8_t &buttons)
+{
+    if (runLeft == 0 && !StartRun())
+    {
+        return false;
+    }
+
+    --runLeft;
+    buttons = runButtons;
+    return true;
+}
+
+static void PutLE(vector<uint8_t> &out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static uint64_t GetLE(uint8_t const *in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+static void PutFloat(vector<uint8_t> &out, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutLE(out, bits, 4);
+}
+
+static float GetFloat(uint8_t const *in)
+{
+    uint32_t bits = static_cast<uint32_t>(GetLE(in, 4));
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool ParseReplayHeader(uint8_t const *data, size_t size, ReplayHeader &header)
+{
+    if (size < Replay_Header_Size_V1 || memcmp(data, Replay_Magic, 4) != 0)
+    {
+        return false;
+    }
+
+    header.version = static_cast<uint16_t>(GetLE(data + 4, 2));
+    header.tickRate = static_cast<uint16_t>(GetLE(data + 6, 2));
+    header.seed = GetLE(data + 8, 8);
+    header.tickCount = static_cast<uint32_t>(GetLE(data + 16, 4));
+    header.runBytes = static_cast<uint32_t>(GetLE(data + 20, 4));
+    header.keyframeInterval = 0;
+    header.keyframeCount = 0;
+    header.size = Replay_Header_Size_V1;
+
+    if (header.version == 1)
+    {
+        return true;
+    }
+    if (header.version != 2 || size < Replay_Header_Size_V2)
+    {
+        return false;
+    }
+
+    header.keyframeInterval = static_cast<uint32_t>(GetLE(data + 24, 4));
+    header.keyframeCount = static_cast<uint32_t>(GetLE(data + 28, 4));
+    header.size = Replay_Header_Size_V2;
+    return true;
+}
+
+Keyframe ParseKeyframe(uint8_t const *data)
+{
+    Keyframe keyframe;
+    keyframe.tick = static_cast<uint32_t>(GetLE(data + 0, 4));
+    keyframe.runOffset = static_cast<uint32_t>(GetLE(data + 4, 4));
+    keyframe.runSkip = static_cast<uint32_t>(GetLE(data + 8, 4));
+    keyframe.state.ballX = GetFloat(data + 12);
+    keyframe.state.ballY = GetFloat(data + 16);
+    keyframe.state.ballVX = GetFloat(data + 20);
+    keyframe.state.ballVY = GetFloat(data + 24);
+    keyframe.state.paddleOneY = GetFloat(data + 28);
+    keyframe.state.paddleOneVY = GetFloat(data + 32);
+    keyframe.state.paddleTwoY = GetFloat(data + 36);
+    keyframe.state.paddleTwoVY = GetFloat(data + 40);
+    keyframe.state.playerOneScore = static_cast<int32_t>(GetLE(data + 44, 4));
+    keyframe.state.playerTwoScore = static_cast<int32_t>(GetLE(data + 48, 4));
+    keyframe.state.rngState = GetLE(data + 52, 8);
+    return keyframe;
+}
+
+static void PutKeyframe(vector<uint8_t> &out, Keyframe const &keyframe)
+{
+    PutLE(out, keyframe.tick, 4);
+    PutLE(out, keyframe.runOffset, 4);
+    PutLE(out, keyframe.runSkip, 4);
+    PutFloat(out, keyframe.state.ballX);
+    PutFloat(out, keyframe.state.ballY);
+    PutFloat(out, keyframe.state.ballVX);
+    PutFloat(out, keyframe.state.ballVY);
+    PutFloat(out, keyframe.state.paddleOneY);
+    PutFloat(out, keyframe.state.paddleOneVY);
+    PutFloat(out, keyframe.state.paddleTwoY);
+    PutFloat(out, keyframe.state.paddleTwoVY);
+    PutLE(out, static_cast<uint32_t>(keyframe.state.playerOneScore), 4);
+    PutLE(out, static_cast<uint32_t>(keyframe.state.playerTwoScore), 4);
+    PutLE(out, keyframe.state.rngState, 8);
+}
+
+bool SaveReplay(string const &path, Replay const &replay)
+{
+    vector<uint8_t> header(Replay_Magic, Replay_Magic + 4);
+    PutLE(header, Replay_Version, 2);
+    PutLE(header, replay.tickRate, 2);
+    PutLE(header, replay.seed, 8);
+    PutLE(header, replay.tickCount, 4);
+    PutLE(header, replay.runs.size(), 4);
+    PutLE(header, replay.keyframeInterval, 4);
+    PutLE(header, replay.keyframes.size(), 4);
+
+    vector<uint8_t> keyframes;
+    for (Keyframe const &keyframe : replay.keyframes)
+    {
+        PutKeyframe(keyframes, keyframe);
+    }
+
+    ofstream file(path, ios::binary);
+    file.write(reinterpret_cast<char const *>(header.data()), header.size());
+    file.write(reinterpret_cast<char const *>(replay.runs.data()), replay.runs.size());
+    file.write(reinterpret_cast<char const *>(keyframes.data()), keyframes.size());
+
+    if (!file)
+    {
+        cout << "Couldn't write replay " << path << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool LoadReplay(string const &path, Replay &replay)
+{
+    ifstream file(path, ios::binary);
+    vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+    ReplayHeader header;
+    if (!ParseReplayHeader(data.data(), data.size(), header))
+    {
+        cout << path << " is not a replay this version can read\n";
+        return false;
+    }
+
+    size_t keyframeBytes = static_cast<size_t>(header.keyframeCount) * Replay_Keyframe_Size;
+    if (data.size() < header.size + header.runBytes + keyframeBytes)
+    {
+        cout << "Replay " << path << " is truncated\n";
+        return false;
+    }
+
+    replay.tickRate = header.tickRate;
+    replay.seed = header.seed;
+    replay.tickCount = header.tickCount;
+    replay.keyframeInterval = header.keyframeInterval;
+
+    uint8_t const *runs = data.data() + header.size;
+    replay.runs.assign(runs, runs + header.runBytes);
+
+    replay.keyframes.clear();
+    for (uint32_t i = 0; i < header.keyframeCount; i++)
+    {
+        replay.keyframes.push_back(ParseKeyframe(runs + header.runBytes + i * Replay_Keyframe_Size));
+    }
+    return true;
+}
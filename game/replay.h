@@ -0,0 +1,121 @@
+// Match replays: the seed plus every tick's buttons, so playback just
+// re-simulates the match.
+//
+// File layout (little-endian):
+//   "PRPL"                   magic
+//   uint16 version           Replay_Version
+//   uint16 tickRate          ticks per second the match was played at
+//   uint64 seed              Match seed
+//   uint32 tickCount         number of ticks recorded
+//   uint32 runBytes          size of the run data
+//   uint32 keyframeInterval  ticks between keyframes (version 2)
+//   uint32 keyframeCount     entries in the keyframe index (version 2)
+//   runs                     run-length encoded PackButtons masks
+//   keyframes                Replay_Keyframe_Size bytes each (version 2)
+//
+// Every run starts with one byte: the low 4 bits are the buttons mask, the
+// high 4 bits the run length minus one. A high nibble of 15 means the
+// length didn't fit and a LEB128 varint with (length - 16) follows. Holding
+// one combination for ten seconds costs three bytes.
+//
+// Keyframes are full match states taken every keyframeInterval ticks, with
+// where that tick sits in the run data. Seeking restores the closest one
+// before the target and only re-simulates from there.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pong.h"
+
+const uint16_t Replay_Version = 2;
+
+// Seconds of play between keyframes
+const int Replay_Keyframe_Seconds = 10;
+
+struct Keyframe
+{
+    uint32_t tick; // State before this tick is simulated
+    uint32_t runOffset; // Byte offset of the run holding this tick
+    uint32_t runSkip; // Ticks of that run already played
+    GameState state;
+};
+
+// Serialized size of one Keyframe
+const size_t Replay_Keyframe_Size = 3 * 4 + 8 * 4 + 2 * 4 + 8;
+
+struct Replay
+{
+    uint16_t tickRate = 0;
+    uint64_t seed = 0;
+    uint32_t tickCount = 0;
+    uint32_t keyframeInterval = 0; // 0 when there are no keyframes
+    std::vector<uint8_t> runs;
+    std::vector<Keyframe> keyframes;
+};
+
+class ReplayRecorder
+{
+public:
+    ReplayRecorder(uint64_t seed, int tickRate);
+
+    // Buttons held for the tick about to be simulated, and the match as it
+    // is before that tick (for keyframes)
+    void Record(uint8_t buttons, Match const &match);
+
+    // Flush the open run and hand over the replay
+    Replay Finish();
+
+private:
+    void FlushRun();
+
+    Replay replay;
+    uint8_t runButtons = 0;
+    uint32_t runLength = 0;
+};
+
+// Hands the recorded masks back one tick at a time
+class ReplayPlayer
+{
+public:
+    explicit ReplayPlayer(Replay const &replay)
+        : runs(replay.runs.data()), end(replay.runs.data() + replay.runs.size()) {}
+
+    // Start at a run boundary, skipping the first skip ticks of that run
+    ReplayPlayer(uint8_t const *runs, size_t size, uint32_t skip = 0);
+
+    // False once the replay is over (or the run data is broken)
+    bool Next(uint8_t &buttons);
+
+private:
+    bool StartRun();
+
+    uint8_t const *runs;
+    uint8_t const *end;
+    uint8_t runButtons = 0;
+    uint64_t runLeft = 0;
+};
+
+// Both return false (and print why) on failure. LoadReplay also reads
+// version 1 files, which just have no keyframes.
+bool SaveReplay(std::string const &path, Replay const &replay);
+bool LoadReplay(std::string const &path, Replay &replay);
+
+// Shared with the memory-mapped reader
+struct ReplayHeader
+{
+    uint16_t version;
+    uint16_t tickRate;
+    uint64_t seed;
+    uint32_t tickCount;
+    uint32_t runBytes;
+    uint32_t keyframeInterval;
+    uint32_t keyframeCount;
+    size_t size; // Bytes the header takes in this version
+};
+
+// Parse the header at the front of data. False if it isn't a replay.
+bool ParseReplayHeader(uint8_t const *data, size_t size, ReplayHeader &header);
+Keyframe ParseKeyframe(uint8_t const *data);
@@ -0,0 +1,174 @@
+#include "replay_reader.h"
+
+#include <iostream>
+
+#include "pong.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+ReplayReader::~ReplayReader()
+{
+    Close();
+}
+
+bool ReplayReader::Open(string const &path)
+{
+    Close();
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        cout << "Couldn't open replay " << path << '\n';
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    data = mapping ? static_cast<uint8_t const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        cout << "Couldn't open replay " << path << '\n';
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        size = static_cast<size_t>(info.st_size);
+        void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = view == MAP_FAILED ? nullptr : static_cast<uint8_t const *>(view);
+    }
+
+    // The mapping stays valid after the descriptor is gone
+    close(fd);
+#endif
+
+    if (data == nullptr)
+    {
+        cout << "Couldn't map replay " << path << '\n';
+        Close();
+        return false;
+    }
+
+    if (!ParseReplayHeader(data, size, header) || header.tickRate == 0 ||
+        size < header.size + header.runBytes + static_cast<size_t>(header.keyframeCount) * Replay_Keyframe_Size)
+    {
+        cout << path << " is not a replay this version can read\n";
+        Close();
+        return false;
+    }
+
+    runs = data + header.size;
+    keyframes = runs + header.runBytes;
+
+#ifndef _WIN32
+    // Playback walks the runs front to back. madvise wants a page-aligned
+    // start and the runs sit right after the header, so round down.
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(runs) & ~(page - 1);
+    size_t length = reinterpret_cast<uintptr_t>(runs) - start + header.runBytes;
+    if (length > 0 && madvise(reinterpret_cast<void *>(start), length, MADV_SEQUENTIAL) != 0)
+    {
+        // Only a hint, playback works without it
+        cout << "madvise on replay " << path << " failed: " << strerror(errno) << '\n';
+    }
+#endif
+
+    return true;
+}
+
+void ReplayReader::Close()
+{
+#ifdef _WIN32
+    if (data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr)
+    {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = nullptr;
+#else
+    if (data != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+#endif
+
+    data = nullptr;
+    size = 0;
+    runs = nullptr;
+    keyframes = nullptr;
+    header = ReplayHeader{};
+}
+
+ReplayPlayer ReplayReader::Player() const
+{
+    return ReplayPlayer(runs, header.runBytes);
+}
+
+ReplayPlayer ReplayReader::Seek(uint32_t tick, Match &match) const
+{
+    if (tick > header.tickCount)
+    {
+        tick = header.tickCount;
+    }
+
+    match = Match(header.seed);
+    ReplayPlayer player = Player();
+    uint32_t at = 0;
+
+    // Keyframes sit at every multiple of the interval, so no search needed
+    if (header.keyframeCount > 0 && header.keyframeInterval > 0)
+    {
+        uint32_t index = tick / header.keyframeInterval;
+        if (index >= header.keyframeCount)
+        {
+            index = header.keyframeCount - 1;
+        }
+
+        Keyframe keyframe = ParseKeyframe(keyframes + index * Replay_Keyframe_Size);
+        if (keyframe.tick <= tick && keyframe.runOffset <= header.runBytes)
+        {
+            match.Restore(keyframe.state);
+            player = ReplayPlayer(runs + keyframe.runOffset, header.runBytes - keyframe.runOffset, keyframe.runSkip);
+            at = keyframe.tick;
+        }
+    }
+
+    const float tickDt = 1000.0f / header.tickRate;
+    for (uint8_t mask; at < tick && player.Next(mask); at++)
+    {
+        bool buttons[4];
+        UnpackButtons(mask, buttons);
+        match.SetButtons(buttons);
+        match.Tick(tickDt);
+    }
+
+    return player;
+}
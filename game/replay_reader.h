@@ -0,0 +1,50 @@
+// Memory-mapped replay reader for long matches. The file is mapped, not
+// read, and input runs and keyframes are decoded straight out of the
+// mapping. Seek() jumps to any tick by restoring the keyframe at or before
+// it and re-simulating at most one keyframe interval.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "pong.h"
+#include "replay.h"
+
+class ReplayReader
+{
+public:
+    ReplayReader() = default;
+    ~ReplayReader();
+
+    ReplayReader(ReplayReader const &) = delete;
+    ReplayReader &operator=(ReplayReader const &) = delete;
+
+    // False (and prints why) if the file can't be mapped or isn't a replay
+    bool Open(std::string const &path);
+    void Close();
+
+    uint16_t TickRate() const { return header.tickRate; }
+    uint64_t Seed() const { return header.seed; }
+    uint32_t TickCount() const { return header.tickCount; }
+    uint32_t KeyframeCount() const { return header.keyframeCount; }
+
+    // Player for the whole replay, from tick 0
+    ReplayPlayer Player() const;
+
+    // Put match in the state it had before tick was simulated and return a
+    // player that continues from there. tick is clamped to TickCount().
+    ReplayPlayer Seek(uint32_t tick, Match &match) const;
+
+private:
+    uint8_t const *data = nullptr;
+    size_t size = 0;
+    ReplayHeader header{};
+    uint8_t const *runs = nullptr;
+    uint8_t const *keyframes = nullptr;
+
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+};
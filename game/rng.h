@@ -0,0 +1,40 @@
+// Small seeded random generator (SplitMix64). Replaces the global rand()
+// so every match has its own reproducible stream and threads don't share
+// state. The whole state is one 64-bit word, cheap to copy or save.
+#pragma once
+
+#include <cstdint>
+
+class Rng
+{
+public:
+    explicit Rng(uint64_t seed = 1) : state(seed) {}
+
+    uint64_t NextU64()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t NextU32()
+    {
+        return static_cast<uint32_t>(NextU64() >> 32);
+    }
+
+    // Uniform in [0, 1)
+    float NextFloat()
+    {
+        return (NextU32() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    uint64_t state;
+};
+
+// Independent seed for stream n derived from one base seed
+inline uint64_t SeedFor(uint64_t seed, uint64_t n)
+{
+    Rng rng(seed ^ (n * 0xD1B54A32D192ED03ull));
+    return rng.NextU64();
+}
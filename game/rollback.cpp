@@ -0,0 +1,180 @@
+#include "rollback.h"
+
+#include <cstring>
+
+static const uint8_t Packet_Inputs = 'I';
+
+static int Slot(uint64_t frame)
+{
+    return static_cast<int>(frame % Rollback_Ring_Size);
+}
+
+static void PutU32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+static uint32_t GetU32(uint8_t const *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+RollbackSession::RollbackSession(int localPlayer, uint64_t seed, float tickDt)
+    : localPlayer(localPlayer), tickDt(tickDt), match(seed)
+{
+    for (int i = 0; i < Rollback_Ring_Size; i++)
+    {
+        remoteInputFrame[i] = -1;
+    }
+}
+
+bool RollbackSession::CanAdvance() const
+{
+    return static_cast<int64_t>(frame) - remoteConfirmed <= Max_Prediction_Frames;
+}
+
+uint32_t RollbackSession::ConfirmedFrame() const
+{
+    int64_t confirmed = remoteConfirmed + 1;
+    return static_cast<uint32_t>(confirmed < frame ? confirmed : frame);
+}
+
+uint8_t RollbackSession::PredictRemote() const
+{
+    // They're still holding whatever we last heard
+    return remoteConfirmed >= 0 ? remoteInputs[Slot(remoteConfirmed)] : 0;
+}
+
+void RollbackSession::Simulate(uint32_t simFrame)
+{
+    int slot = Slot(simFrame);
+
+    uint8_t remote = remoteInputFrame[slot] == simFrame ? remoteInputs[slot] : PredictRemote();
+    usedRemote[slot] = remote;
+
+    uint8_t playerOne = localPlayer == 0 ? localInputs[slot] : remote;
+    uint8_t playerTwo = localPlayer == 0 ? remote : localInputs[slot];
+
+    bool buttons[4];
+    UnpackButtons(static_cast<uint8_t>((playerOne & 3) | ((playerTwo & 3) << 2)), buttons);
+
+    match.Save(states[slot]);
+    match.SetButtons(buttons);
+    match.Tick(tickDt);
+}
+
+void RollbackSession::Synchronize()
+{
+    if (rollbackFrom < 0)
+    {
+        return;
+    }
+
+    uint32_t from = static_cast<uint32_t>(rollbackFrom);
+    rollbackFrom = -1;
+
+    match.Restore(states[Slot(from)]);
+    for (uint32_t f = from; f < frame; f++)
+    {
+        Simulate(f);
+    }
+
+    int length = static_cast<int>(frame - from);
+    ++rollbacks;
+    resimulatedFrames += length;
+    if (length > longestRollback)
+    {
+        longestRollback = length;
+    }
+}
+
+void RollbackSession::AdvanceFrame(uint8_t localInput)
+{
+    Synchronize();
+
+    localInputs[Slot(frame)] = localInput & 3;
+    Simulate(frame);
+    ++frame;
+}
+
+void RollbackSession::AddRemoteInput(uint32_t inputFrame, uint8_t input)
+{
+    // Old news, or so far ahead it would wrap the ring (can't happen with a
+    // well-behaved peer)
+    if (inputFrame <= remoteConfirmed || inputFrame >= remoteConfirmed + Rollback_Ring_Size)
+    {
+        return;
+    }
+
+    int slot = Slot(inputFrame);
+    if (remoteInputFrame[slot] == inputFrame)
+    {
+        return;
+    }
+
+    remoteInputs[slot] = input & 3;
+    remoteInputFrame[slot] = inputFrame;
+
+    // Already simulated on a guess that turned out wrong
+    if (inputFrame < frame && usedRemote[slot] != remoteInputs[slot] &&
+        (rollbackFrom < 0 || inputFrame < rollbackFrom))
+    {
+        rollbackFrom = inputFrame;
+    }
+
+    while (remoteInputFrame[Slot(remoteConfirmed + 1)] == remoteConfirmed + 1)
+    {
+        ++remoteConfirmed;
+    }
+}
+
+// Packet: type, ack (first remote frame we still need), first frame of
+// the inputs, count, then one input per frame.
+size_t RollbackSession::BuildPacket(uint8_t *buffer, size_t size) const
+{
+    int64_t first = remoteAcked + 1;
+    if (first < static_cast<int64_t>(frame) - Max_Packet_Inputs)
+    {
+        first = static_cast<int64_t>(frame) - Max_Packet_Inputs;
+    }
+    int count = static_cast<int>(frame - first);
+
+    if (size < static_cast<size_t>(10 + count))
+    {
+        return 0;
+    }
+
+    buffer[0] = Packet_Inputs;
+    PutU32(buffer + 1, static_cast<uint32_t>(remoteConfirmed + 1));
+    PutU32(buffer + 5, static_cast<uint32_t>(first));
+    buffer[9] = static_cast<uint8_t>(count);
+    for (int i = 0; i < count; i++)
+    {
+        buffer[10 + i] = localInputs[Slot(first + i)];
+    }
+
+    return 10 + count;
+}
+
+void RollbackSession::ReadPacket(uint8_t const *data, size_t size)
+{
+    if (size < 10 || data[0] != Packet_Inputs || size < static_cast<size_t>(10 + data[9]))
+    {
+        return;
+    }
+
+    int64_t acked = static_cast<int64_t>(GetU32(data + 1)) - 1;
+    if (acked > remoteAcked)
+    {
+        remoteAcked = acked < frame ? acked : static_cast<int64_t>(frame) - 1;
+    }
+
+    uint32_t first = GetU32(data + 5);
+    for (int i = 0; i < data[9]; i++)
+    {
+        AddRemoteInput(first + i, data[10 + i]);
+    }
+}
@@ -0,0 +1,86 @@
+// Two-player rollback netplay (the GGPO approach).
+//
+// Each side applies its own input the moment it's pressed and predicts
+// the other player's input (they keep holding whatever they last sent).
+// When the real remote input for a frame arrives and differs from the
+// guess, the session restores the GameState saved before that frame and
+// re-simulates up to the present with the corrected inputs.
+//
+// Inputs are each player's two buttons (up, down) as bits 0 and 1. The
+// local player's go to the Buttons of paddle one or two depending on
+// which side it plays.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pong.h"
+
+// Frames of history kept for inputs and states
+const int Rollback_Ring_Size = 128;
+
+// How far ahead of the last confirmed remote input we're allowed to run.
+// 32 frames at 120 Hz is ~267 ms, comfortably above a 150 ms round trip.
+const int Max_Prediction_Frames = 32;
+
+// Most inputs one packet carries. The remote can be missing up to two
+// prediction windows of ours: it may run a window ahead of what it's seen
+// from us, and we a window ahead of what we've seen from it.
+const int Max_Packet_Inputs = 2 * Max_Prediction_Frames + 1;
+
+// Largest packet BuildPacket writes
+const size_t Rollback_Packet_Size = 1 + 4 + 4 + 1 + Max_Packet_Inputs;
+
+class RollbackSession
+{
+public:
+    // localPlayer is 0 (paddle one) or 1 (paddle two). Both sides must use
+    // the same seed and tickDt.
+    RollbackSession(int localPlayer, uint64_t seed, float tickDt);
+
+    // False while we're too far ahead of the remote and should wait
+    bool CanAdvance() const;
+
+    // Simulate the next frame with this local input. Only call when
+    // CanAdvance() says so.
+    void AdvanceFrame(uint8_t localInput);
+
+    // Apply any pending correction without moving forward
+    void Synchronize();
+
+    // Packet carrying our unacknowledged inputs and our ack. Returns size.
+    size_t BuildPacket(uint8_t *buffer, size_t size) const;
+    void ReadPacket(uint8_t const *data, size_t size);
+
+    Match const &CurrentMatch() const { return match; }
+
+    // Next frame to simulate
+    uint32_t Frame() const { return frame; }
+
+    // Every frame before this one has real inputs from both players
+    uint32_t ConfirmedFrame() const;
+
+    long long rollbacks = 0;
+    long long resimulatedFrames = 0;
+    int longestRollback = 0;
+
+private:
+    void AddRemoteInput(uint32_t inputFrame, uint8_t input);
+    uint8_t PredictRemote() const;
+    void Simulate(uint32_t simFrame);
+
+    int localPlayer;
+    float tickDt;
+    Match match;
+
+    uint32_t frame = 0;
+    int64_t remoteConfirmed = -1; // Remote inputs are known for every frame up to here
+    int64_t remoteAcked = -1; // Remote has our inputs up to here
+    int64_t rollbackFrom = -1; // Earliest frame simulated with a wrong guess
+
+    uint8_t localInputs[Rollback_Ring_Size] = {};
+    uint8_t remoteInputs[Rollback_Ring_Size] = {};
+    int64_t remoteInputFrame[Rollback_Ring_Size]; // Which frame remoteInputs[i] holds, -1 if none
+    uint8_t usedRemote[Rollback_Ring_Size] = {}; // Remote input the last simulation of a frame used
+    GameState states[Rollback_Ring_Size]; // State before each frame
+};
@@ -0,0 +1,62 @@
+// Game rules: the size of the field and of everything on it, and how fast
+// things move.
+//
+// The simulation is templated on a rules type and reads it as rules.width,
+// rules.ballSpeed and so on. StandardRules, the shipped game, has them as
+// static constexpr, so its instantiation folds them in like the old global
+// constants did. RuntimeRules has the same names as plain members, for
+// trying other values without a rebuild.
+#pragma once
+
+struct StandardRules
+{
+    static constexpr float width = 1280.0f;
+    static constexpr float height = 720.0f;
+    static constexpr float ballWidth = 15.0f;
+    static constexpr float ballHeight = 15.0f;
+    static constexpr float paddleWidth = 10.0f;
+    static constexpr float paddleHeight = 80.0f;
+    static constexpr float paddleSpeed = 1.0f; // px/ms
+    static constexpr float ballSpeed = 0.8f;   // px/ms
+};
+
+struct RuntimeRules
+{
+    float width = StandardRules::width;
+    float height = StandardRules::height;
+    float ballWidth = StandardRules::ballWidth;
+    float ballHeight = StandardRules::ballHeight;
+    float paddleWidth = StandardRules::paddleWidth;
+    float paddleHeight = StandardRules::paddleHeight;
+    float paddleSpeed = StandardRules::paddleSpeed;
+    float ballSpeed = StandardRules::ballSpeed;
+
+    // Same values as StandardRules, so its faster instantiation can be used
+    bool IsStandard() const
+    {
+        return width == StandardRules::width && height == StandardRules::height &&
+               ballWidth == StandardRules::ballWidth && ballHeight == StandardRules::ballHeight &&
+               paddleWidth == StandardRules::paddleWidth && paddleHeight == StandardRules::paddleHeight &&
+               paddleSpeed == StandardRules::paddleSpeed && ballSpeed == StandardRules::ballSpeed;
+    }
+
+    // Everything positive, and the ball and the paddles (50 px in from
+    // each side) fit on the field
+    bool IsValid() const
+    {
+        return ballWidth > 0.0f && ballHeight > 0.0f && paddleWidth > 0.0f && paddleHeight > 0.0f &&
+               paddleSpeed > 0.0f && ballSpeed > 0.0f &&
+               width > 100.0f + 2.0f * paddleWidth && height > paddleHeight && height > ballHeight;
+    }
+};
+
+// The standard rules under their old names, for code that only ever plays
+// those (the batch and SIMD kernels, the multi-ball arena, drawing)
+const int WIDTH = static_cast<int>(StandardRules::width);
+const int HEIGHT = static_cast<int>(StandardRules::height);
+const int Ball_Width = static_cast<int>(StandardRules::ballWidth);
+const int Ball_Height = static_cast<int>(StandardRules::ballHeight);
+const int Paddle_Width = static_cast<int>(StandardRules::paddleWidth);
+const int Paddle_Height = static_cast<int>(StandardRules::paddleHeight);
+const float Paddle_Speed = StandardRules::paddleSpeed;
+const float Ball_Speed = StandardRules::ballSpeed;
@@ -0,0 +1,262 @@
+#include "runner.h"
+
+#include "ai.h"
+#include "pong.h"
+
+static uint64_t PackRange(uint32_t begin, uint32_t end)
+{
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+
+WorkStealingPool::WorkStealingPool(int workers)
+{
+    if (workers <= 0)
+    {
+        workers = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    if (workers <= 0)
+    {
+        workers = 1;
+    }
+
+    slices = std::vector<Slice>(workers);
+
+    for (int w = 1; w < workers; w++)
+    {
+        threads.emplace_back(&WorkStealingPool::WorkerLoop, this, w);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Run(int count, std::function<void(int, int)> const &work)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    // Even split up front; stealing evens out whatever's left over
+    const uint64_t workers = slices.size();
+    for (uint64_t w = 0; w < workers; w++)
+    {
+        uint32_t begin = static_cast<uint32_t>(count * w / workers);
+        uint32_t end = static_cast<uint32_t>(count * (w + 1) / workers);
+        slices[w].range.store(PackRange(begin, end), std::memory_order_relaxed);
+    }
+
+    task = &work;
+    remaining.store(count, std::memory_order_relaxed);
+
+    if (threads.empty())
+    {
+        Work(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        busyWorkers = static_cast<int>(threads.size());
+    }
+    wake.notify_all();
+
+    Work(0);
+
+    // Don't return (and let work go out of scope) while anyone still uses it
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void WorkStealingPool::WorkerLoop(int worker)
+{
+    uint64_t seen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+            {
+                return;
+            }
+            seen = generation;
+        }
+
+        Work(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::Work(int worker)
+{
+    while (remaining.load(std::memory_order_acquire) > 0)
+    {
+        int index;
+        if (TakeOwn(worker, index))
+        {
+            (*task)(index, worker);
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        else if (!Steal(worker))
+        {
+            // Everything left is already running somewhere else
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool WorkStealingPool::TakeOwn(int worker, int &index)
+{
+    std::atomic<uint64_t> &range = slices[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        uint32_t begin = static_cast<uint32_t>(current >> 32);
+        uint32_t end = static_cast<uint32_t>(current);
+        if (begin >= end)
+        {
+            return false;
+        }
+
+        if (range.compare_exchange_weak(current, PackRange(begin + 1, end), std::memory_order_acq_rel))
+        {
+            index = static_cast<int>(begin);
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::Steal(int worker)
+{
+    const int workers = WorkerCount();
+
+    for (int k = 1; k < workers; k++)
+    {
+        std::atomic<uint64_t> &victim = slices[(worker + k) % workers].range;
+        uint64_t current = victim.load(std::memory_order_acquire);
+
+        uint32_t begin = static_cast<uint32_t>(current >> 32);
+        uint32_t end = static_cast<uint32_t>(current);
+        if (begin >= end)
+        {
+            continue;
+        }
+
+        // Take the back half, leaving the front (which the owner is
+        // working through) alone
+        uint32_t split = end - (end - begin + 1) / 2;
+        if (victim.compare_exchange_strong(current, PackRange(begin, split), std::memory_order_acq_rel))
+        {
+            // Our own slice is empty, so nobody else can be changing it
+            slices[worker].range.store(PackRange(split, end), std::memory_order_release);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+MatchRunStats &MatchRunStats::operator+=(MatchRunStats const &rhs)
+{
+    matches += rhs.matches;
+    ticks += rhs.ticks;
+    points += rhs.points;
+    playerOneWins += rhs.playerOneWins;
+    playerTwoWins += rhs.playerTwoWins;
+    return *this;
+}
+
+// Everything a worker touches while playing, on its own cache lines
+struct alignas(64) WorkerState
+{
+    MatchRunStats stats;
+    ScriptedInput script;
+};
+
+template <typename Rules>
+static MatchRunStats PlayMatches(WorkStealingPool &pool, MatchRunConfig const &config, Rules const &rules)
+{
+    std::vector<WorkerState> workers(pool.WorkerCount());
+
+    pool.Run(config.matches, [&](int n, int worker) {
+        WorkerState &state = workers[worker];
+
+        BasicMatch<Rules> match(SeedFor(config.seed, 2 * n), rules);
+        state.script = ScriptedInput(SeedFor(config.seed, 2 * n + 1));
+        bool buttons[4] = {};
+
+        long ticks = 0;
+        while (ticks < config.maxTicks &&
+               match.playerOneScore < config.scoreLimit &&
+               match.playerTwoScore < config.scoreLimit)
+        {
+            if (config.input == InputMode::AI)
+            {
+                ChaseBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown], rules);
+                ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown], rules);
+            }
+            else if (config.input == InputMode::Intercept)
+            {
+                InterceptBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown], rules);
+                InterceptBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown], rules);
+            }
+            else
+            {
+                state.script.Next(buttons);
+            }
+
+            match.SetButtons(buttons);
+            match.Tick(config.tickDt);
+            ++ticks;
+        }
+
+        state.stats.matches += 1;
+        state.stats.ticks += ticks;
+        state.stats.points += match.playerOneScore + match.playerTwoScore;
+        if (match.playerOneScore > match.playerTwoScore)
+        {
+            ++state.stats.playerOneWins;
+        }
+        else if (match.playerTwoScore > match.playerOneScore)
+        {
+            ++state.stats.playerTwoWins;
+        }
+    });
+
+    // Merge once everyone is done
+    MatchRunStats total;
+    for (WorkerState const &state : workers)
+    {
+        total += state.stats;
+    }
+    return total;
+}
+
+MatchRunStats RunMatches(WorkStealingPool &pool, MatchRunConfig const &config)
+{
+    if (config.rules.IsStandard())
+    {
+        return PlayMatches(pool, config, StandardRules());
+    }
+    return PlayMatches(pool, config, config.rules);
+}
@@ -0,0 +1,94 @@
+// Runs many matches across all cores.
+//
+// WorkStealingPool hands every worker a contiguous slice of the task
+// indices. A worker takes tasks off the front of its own slice, and once it
+// runs dry steals the back half of someone else's. The slices are single
+// atomic words, so there are no locks anywhere on the task path.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rules.h"
+
+class WorkStealingPool
+{
+public:
+    // 0 workers means one per hardware thread. The calling thread is
+    // always worker 0, so a pool of 1 spawns no threads at all.
+    explicit WorkStealingPool(int workers = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(WorkStealingPool const &) = delete;
+    WorkStealingPool &operator=(WorkStealingPool const &) = delete;
+
+    int WorkerCount() const { return static_cast<int>(slices.size()); }
+
+    // Call task(index, worker) for every index in [0, count) and wait for
+    // all of them. worker is in [0, WorkerCount()) and never runs two tasks
+    // at once, so it can index per-worker buffers.
+    void Run(int count, std::function<void(int, int)> const &task);
+
+private:
+    // [begin, end) packed into one word so owner and thieves can CAS it
+    struct alignas(64) Slice
+    {
+        std::atomic<uint64_t> range{0};
+    };
+
+    void WorkerLoop(int worker);
+    void Work(int worker);
+    bool TakeOwn(int worker, int &index);
+    bool Steal(int worker);
+
+    std::vector<Slice> slices;
+    std::vector<std::thread> threads;
+
+    std::function<void(int, int)> const *task = nullptr;
+    alignas(64) std::atomic<int> remaining{0};
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int busyWorkers = 0;
+    bool stopping = false;
+};
+
+enum class InputMode
+{
+    AI,        // ChaseBall
+    Intercept, // InterceptBall
+    Scripted
+};
+
+struct MatchRunConfig
+{
+    int matches = 100;
+    int scoreLimit = 11;
+    long maxTicks = 72000; // Per match (10 minutes at 120 Hz), in case nobody ever scores
+    float tickDt = 1000.0f / 120.0f;
+    uint64_t seed = 1;
+    InputMode input = InputMode::AI;
+    RuntimeRules rules; // Standard ones run on the constant-folded Match
+};
+
+struct MatchRunStats
+{
+    long long matches = 0;
+    long long ticks = 0;
+    long long points = 0;
+    long long playerOneWins = 0;
+    long long playerTwoWins = 0;
+
+    MatchRunStats &operator+=(MatchRunStats const &rhs);
+};
+
+// Play config.matches matches on the pool. Match n is seeded from
+// (config.seed, n) so results don't depend on which worker ran it.
+MatchRunStats RunMatches(WorkStealingPool &pool, MatchRunConfig const &config);
@@ -0,0 +1,158 @@
+#include "scene.h"
+
+#include "profile.h"
+#include "rules.h"
+
+using namespace std;
+
+// main()'s center line, every point but each fifth
+static vector<Point> CenterLine()
+{
+    vector<Point> points;
+    for (int i = 0; i < HEIGHT; i++)
+    {
+        if (i % 5 != 0)
+        {
+            points.push_back({WIDTH / 2, i});
+        }
+    }
+    return points;
+}
+
+static const vector<Point> Center_Line = CenterLine();
+
+void DrawScene(Framebuffer &framebuffer, Scene const &scene)
+{
+    PROFILE_START(clearTimer, Phase_Clear);
+    framebuffer.Clear(Color_Background);
+    PROFILE_STOP(clearTimer);
+
+    // The line is one column, so skip it unless the clip crosses it
+    Rect clip = framebuffer.Clip();
+    if (clip.x <= WIDTH / 2 && WIDTH / 2 < clip.x + clip.w)
+    {
+        framebuffer.DrawPoints(Center_Line.data(), static_cast<int>(Center_Line.size()), Color_Foreground);
+    }
+
+    framebuffer.FillRects(scene.boxes.data(), static_cast<int>(scene.boxes.size()), Color_Foreground);
+
+    for (Glyph const &glyph : scene.glyphs)
+    {
+        framebuffer.BlitMask(glyph.x, glyph.y, glyph.mask, glyph.width, glyph.height, glyph.pitch, Color_Foreground);
+    }
+}
+
+DamageList::DamageList(int width, int height) : width(width), height(height)
+{
+}
+
+void DamageList::Add(Rect const &rect)
+{
+    if (all)
+    {
+        return;
+    }
+
+    Rect merged = Intersection(rect, {0, 0, width, height});
+    if (IsEmpty(merged))
+    {
+        return;
+    }
+
+    // Soak up everything it overlaps or touches; a grown rect can reach
+    // ones it missed before, so go round until nothing changes
+    bool grew = true;
+    while (grew)
+    {
+        grew = false;
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            Rect const &other = rects[i];
+            bool touching = merged.x <= other.x + other.w && other.x <= merged.x + merged.w &&
+                            merged.y <= other.y + other.h && other.y <= merged.y + merged.h;
+            if (touching)
+            {
+                merged = Union(merged, other);
+                rects[i] = rects.back();
+                rects.pop_back();
+                grew = true;
+                break;
+            }
+        }
+    }
+    rects.push_back(merged);
+
+    if (static_cast<int>(rects.size()) > Damage_Max_Rects || 2 * Area() > static_cast<long long>(width) * height)
+    {
+        AddAll();
+    }
+}
+
+void DamageList::AddAll()
+{
+    rects.assign(1, Rect{0, 0, width, height});
+    all = true;
+}
+
+static bool SameGlyph(Glyph const &a, Glyph const &b)
+{
+    return a.mask == b.mask && a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+void DamageList::AddChanges(Scene const &previous, Scene const &current)
+{
+    if (previous.boxes.size() != current.boxes.size())
+    {
+        AddAll();
+        return;
+    }
+
+    for (size_t i = 0; i < current.boxes.size() && !all; i++)
+    {
+        if (!(previous.boxes[i] == current.boxes[i]))
+        {
+            Add(previous.boxes[i]);
+            Add(current.boxes[i]);
+        }
+    }
+
+    if (previous.glyphs.size() != current.glyphs.size())
+    {
+        for (Glyph const &glyph : previous.glyphs)
+        {
+            Add({glyph.x, glyph.y, glyph.width, glyph.height});
+        }
+        for (Glyph const &glyph : current.glyphs)
+        {
+            Add({glyph.x, glyph.y, glyph.width, glyph.height});
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < current.glyphs.size(); i++)
+    {
+        Glyph const &before = previous.glyphs[i];
+        Glyph const &after = current.glyphs[i];
+        if (!SameGlyph(before, after))
+        {
+            Add({before.x, before.y, before.width, before.height});
+            Add({after.x, after.y, after.width, after.height});
+        }
+    }
+}
+
+long long DamageList::Area() const
+{
+    long long area = 0;
+    for (Rect const &rect : rects)
+    {
+        area += static_cast<long long>(rect.w) * rect.h;
+    }
+    return area;
+}
+
+void DamageList::Clear()
+{
+    rects.clear();
+    all = false;
+}
@@ -0,0 +1,67 @@
+// One frame of the software path, as data: the boxes (balls, paddles) and
+// text glyphs main() draws over the background and center line.
+//
+// Keeping last frame's Scene around is what makes dirty rectangles work:
+// only what moved or changed between the two needs drawing and presenting,
+// which for a normal match is a few thousand pixels out of 921,600.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+
+// A glyph mask (see Framebuffer::BlitMask) placed on screen. Masks are
+// expected to live in an atlas, so the same pointer is the same glyph.
+struct Glyph
+{
+    uint8_t const *mask = nullptr;
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int pitch = 0;
+};
+
+struct Scene
+{
+    std::vector<Rect> boxes;
+    std::vector<Glyph> glyphs;
+};
+
+// Draws all of it, inside the framebuffer's clip rect
+void DrawScene(Framebuffer &framebuffer, Scene const &scene);
+
+// Past this many rects, or half the screen, a full redraw is cheaper than
+// walking the scene once per rect
+const int Damage_Max_Rects = 32;
+
+// The parts of the screen that have to be redrawn and presented. Rects
+// that overlap or touch are merged as they're added, so none is drawn
+// twice.
+class DamageList
+{
+public:
+    DamageList(int width, int height);
+
+    void Add(Rect const &rect);
+
+    // Everything, e.g. the first frame or after the window was uncovered
+    void AddAll();
+    bool All() const { return all; }
+
+    // Whatever differs between two frames: every box's old and new place,
+    // and every glyph that changed. A different number of boxes damages
+    // all; a different number of glyphs damages where any of them were.
+    void AddChanges(Scene const &previous, Scene const &current);
+
+    std::vector<Rect> const &Rects() const { return rects; }
+    long long Area() const;
+    void Clear();
+
+private:
+    int width;
+    int height;
+    bool all = false;
+    std::vector<Rect> rects;
+};
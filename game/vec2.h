@@ -0,0 +1,296 @@
+// 2D vector math for the scalar and the batched physics.
+//
+// Vec2 is a single vector and constexpr all the way except Length and
+// Normalize, which need sqrt. Vec2x4 (SSE) and Vec2x8 (AVX) hold 4 or 8
+// vectors as one register of x and one of y, and have the same operations,
+// so a loop over structure-of-arrays data reads like the scalar one.
+//
+// Vec2x8 is compiled for AVX whatever the build flags are, so only use it
+// in code that runs after HasAVX2() (collision_simd.h) said yes.
+#pragma once
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PONG_VEC2_SIMD 1
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PONG_AVX_TARGET __attribute__((target("avx")))
+#else
+#define PONG_AVX_TARGET
+#endif
+#endif
+
+class Vec2
+{
+public:
+    constexpr Vec2() : x(0.0f), y(0.0f) {}
+
+    constexpr Vec2(float x, float y) : x(x), y(y) {}
+
+    constexpr Vec2 operator+(Vec2 const &rhs) const // rhs = Right Hand Side
+    {
+        return Vec2(x + rhs.x, y + rhs.y);
+    }
+    constexpr Vec2 operator-(Vec2 const &rhs) const
+    {
+        return Vec2(x - rhs.x, y - rhs.y);
+    }
+    constexpr Vec2 operator-() const
+    {
+        return Vec2(-x, -y);
+    }
+    constexpr Vec2 operator*(float rhs) const
+    {
+        return Vec2(x * rhs, y * rhs);
+    }
+    constexpr Vec2 operator/(float rhs) const
+    {
+        return Vec2(x / rhs, y / rhs);
+    }
+
+    constexpr Vec2 &operator+=(Vec2 const &rhs)
+    {
+        x += rhs.x;
+        y += rhs.y;
+        return *this;
+    }
+    constexpr Vec2 &operator-=(Vec2 const &rhs)
+    {
+        x -= rhs.x;
+        y -= rhs.y;
+        return *this;
+    }
+    constexpr Vec2 &operator*=(float rhs)
+    {
+        x *= rhs;
+        y *= rhs;
+        return *this;
+    }
+
+    constexpr bool operator==(Vec2 const &rhs) const
+    {
+        return x == rhs.x && y == rhs.y;
+    }
+    constexpr bool operator!=(Vec2 const &rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    float x, y;
+};
+
+constexpr Vec2 operator*(float lhs, Vec2 const &rhs)
+{
+    return rhs * lhs;
+}
+
+constexpr float Dot(Vec2 const &a, Vec2 const &b)
+{
+    return a.x * b.x + a.y * b.y;
+}
+
+constexpr float LengthSquared(Vec2 const &v)
+{
+    return Dot(v, v);
+}
+
+inline float Length(Vec2 const &v)
+{
+    return std::sqrt(Dot(v, v));
+}
+
+// Unit vector in the same direction; the zero vector stays zero
+inline Vec2 Normalize(Vec2 const &v)
+{
+    float length = Length(v);
+    return length > 0.0f ? v / length : Vec2();
+}
+
+constexpr Vec2 Min(Vec2 const &a, Vec2 const &b)
+{
+    return Vec2(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y);
+}
+
+constexpr Vec2 Max(Vec2 const &a, Vec2 const &b)
+{
+    return Vec2(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y);
+}
+
+// Per component, into [low, high]
+constexpr Vec2 Clamp(Vec2 const &v, Vec2 const &low, Vec2 const &high)
+{
+    return Max(low, Min(v, high));
+}
+
+// Blend between the last two simulation ticks (alpha in [0, 1])
+constexpr Vec2 Lerp(Vec2 const &from, Vec2 const &to, float alpha)
+{
+    return Vec2(from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha);
+}
+
+#ifdef PONG_VEC2_SIMD
+
+// Four vectors, lane i being (x[i], y[i]). Per-lane scalars (Dot, Length)
+// come back as a plain __m128.
+struct Vec2x4
+{
+    __m128 x, y;
+
+    Vec2x4() = default;
+    Vec2x4(__m128 x, __m128 y) : x(x), y(y) {}
+
+    // Same vector in every lane
+    explicit Vec2x4(Vec2 const &v) : x(_mm_set1_ps(v.x)), y(_mm_set1_ps(v.y)) {}
+
+    static Vec2x4 Load(float const *xs, float const *ys)
+    {
+        return Vec2x4(_mm_loadu_ps(xs), _mm_loadu_ps(ys));
+    }
+    void Store(float *xs, float *ys) const
+    {
+        _mm_storeu_ps(xs, x);
+        _mm_storeu_ps(ys, y);
+    }
+
+    Vec2x4 operator+(Vec2x4 const &rhs) const
+    {
+        return Vec2x4(_mm_add_ps(x, rhs.x), _mm_add_ps(y, rhs.y));
+    }
+    Vec2x4 operator-(Vec2x4 const &rhs) const
+    {
+        return Vec2x4(_mm_sub_ps(x, rhs.x), _mm_sub_ps(y, rhs.y));
+    }
+    Vec2x4 operator*(__m128 rhs) const
+    {
+        return Vec2x4(_mm_mul_ps(x, rhs), _mm_mul_ps(y, rhs));
+    }
+    Vec2x4 operator*(float rhs) const
+    {
+        return *this * _mm_set1_ps(rhs);
+    }
+    Vec2x4 &operator+=(Vec2x4 const &rhs)
+    {
+        return *this = *this + rhs;
+    }
+};
+
+inline __m128 Dot(Vec2x4 const &a, Vec2x4 const &b)
+{
+    return _mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y));
+}
+
+inline __m128 Length(Vec2x4 const &v)
+{
+    return _mm_sqrt_ps(Dot(v, v));
+}
+
+inline Vec2x4 Normalize(Vec2x4 const &v)
+{
+    __m128 length = Length(v);
+    __m128 nonZero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+    return Vec2x4(_mm_and_ps(_mm_div_ps(v.x, length), nonZero), _mm_and_ps(_mm_div_ps(v.y, length), nonZero));
+}
+
+// Operand order matches the scalar ?: so NaN lanes come out the same
+inline Vec2x4 Min(Vec2x4 const &a, Vec2x4 const &b)
+{
+    return Vec2x4(_mm_min_ps(a.x, b.x), _mm_min_ps(a.y, b.y));
+}
+
+inline Vec2x4 Max(Vec2x4 const &a, Vec2x4 const &b)
+{
+    return Vec2x4(_mm_max_ps(a.x, b.x), _mm_max_ps(a.y, b.y));
+}
+
+inline Vec2x4 Clamp(Vec2x4 const &v, Vec2x4 const &low, Vec2x4 const &high)
+{
+    return Max(low, Min(v, high));
+}
+
+inline Vec2x4 Lerp(Vec2x4 const &from, Vec2x4 const &to, float alpha)
+{
+    return from + (to - from) * alpha;
+}
+
+// Eight vectors, same as Vec2x4 on AVX registers
+struct Vec2x8
+{
+    __m256 x, y;
+
+    Vec2x8() = default;
+    PONG_AVX_TARGET Vec2x8(__m256 x, __m256 y) : x(x), y(y) {}
+
+    PONG_AVX_TARGET explicit Vec2x8(Vec2 const &v) : x(_mm256_set1_ps(v.x)), y(_mm256_set1_ps(v.y)) {}
+
+    PONG_AVX_TARGET static Vec2x8 Load(float const *xs, float const *ys)
+    {
+        return Vec2x8(_mm256_loadu_ps(xs), _mm256_loadu_ps(ys));
+    }
+    PONG_AVX_TARGET void Store(float *xs, float *ys) const
+    {
+        _mm256_storeu_ps(xs, x);
+        _mm256_storeu_ps(ys, y);
+    }
+
+    PONG_AVX_TARGET Vec2x8 operator+(Vec2x8 const &rhs) const
+    {
+        return Vec2x8(_mm256_add_ps(x, rhs.x), _mm256_add_ps(y, rhs.y));
+    }
+    PONG_AVX_TARGET Vec2x8 operator-(Vec2x8 const &rhs) const
+    {
+        return Vec2x8(_mm256_sub_ps(x, rhs.x), _mm256_sub_ps(y, rhs.y));
+    }
+    PONG_AVX_TARGET Vec2x8 operator*(__m256 rhs) const
+    {
+        return Vec2x8(_mm256_mul_ps(x, rhs), _mm256_mul_ps(y, rhs));
+    }
+    PONG_AVX_TARGET Vec2x8 operator*(float rhs) const
+    {
+        return *this * _mm256_set1_ps(rhs);
+    }
+    PONG_AVX_TARGET Vec2x8 &operator+=(Vec2x8 const &rhs)
+    {
+        return *this = *this + rhs;
+    }
+};
+
+PONG_AVX_TARGET inline __m256 Dot(Vec2x8 const &a, Vec2x8 const &b)
+{
+    return _mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y));
+}
+
+PONG_AVX_TARGET inline __m256 Length(Vec2x8 const &v)
+{
+    return _mm256_sqrt_ps(Dot(v, v));
+}
+
+PONG_AVX_TARGET inline Vec2x8 Normalize(Vec2x8 const &v)
+{
+    __m256 length = Length(v);
+    __m256 nonZero = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ);
+    return Vec2x8(_mm256_and_ps(_mm256_div_ps(v.x, length), nonZero), _mm256_and_ps(_mm256_div_ps(v.y, length), nonZero));
+}
+
+PONG_AVX_TARGET inline Vec2x8 Min(Vec2x8 const &a, Vec2x8 const &b)
+{
+    return Vec2x8(_mm256_min_ps(a.x, b.x), _mm256_min_ps(a.y, b.y));
+}
+
+PONG_AVX_TARGET inline Vec2x8 Max(Vec2x8 const &a, Vec2x8 const &b)
+{
+    return Vec2x8(_mm256_max_ps(a.x, b.x), _mm256_max_ps(a.y, b.y));
+}
+
+PONG_AVX_TARGET inline Vec2x8 Clamp(Vec2x8 const &v, Vec2x8 const &low, Vec2x8 const &high)
+{
+    return Max(low, Min(v, high));
+}
+
+PONG_AVX_TARGET inline Vec2x8 Lerp(Vec2x8 const &from, Vec2x8 const &to, float alpha)
+{
+    return from + (to - from) * alpha;
+}
+
+#endif
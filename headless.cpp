@@ -0,0 +1,1278 @@
+// Headless Pong: runs matches with no window, renderer or GPU and reports
+// how fast the simulation goes. Only needs the game/ core.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "game/ai.h"
+#include "game/batch.h"
+#include "game/collision_simd.h"
+#include "game/env.h"
+#include "game/framebuffer.h"
+#include "game/multiball.h"
+#include "game/net.h"
+#include "game/pacing.h"
+#include "game/pixels.h"
+#include "game/profile.h"
+#include "game/pong.h"
+#include "game/replay.h"
+#include "game/replay_reader.h"
+#include "game/rollback.h"
+#include "game/scene.h"
+#include "game/runner.h"
+
+using namespace std;
+
+struct Options
+{
+    MatchRunConfig run;
+    bool inputGiven = false; // --input was passed
+    int tickRate = Tick_Rate;
+    int threads = 0; // 0 = one per hardware thread
+    bool batch = false; // Step all matches together for maxTicks ticks
+    string recordPath; // Play one match and save its replay here
+    string playPath; // Re-simulate this replay instead of playing
+    long seekTick = -1; // With playPath: jump to this tick instead
+    bool netplay = false; // Two rollback peers over loopback UDP
+    float rttMs = 150.0f;
+    float jitterMs = 10.0f;
+    int balls = 0; // Multi-ball arena benchmark with this many balls
+    bool ballCollisions = false;
+    int envs = 0; // VecEnv benchmark with this many environments
+    int pixelWidth = 0; // Pixel observation benchmark at this size
+    int pixelHeight = 0;
+    int frameStack = 4;
+    string framePath; // With pixels: save the last frame here as a PGM
+    bool raster = false; // Software rasterizer benchmark at full size
+    double paceFps = 0.0; // Frame pacer check at this rate
+    string profilePath; // Save the per-phase timings here (PONG_PROFILE builds)
+    bool selfCheck = false; // Compare the SIMD kernels with scalar
+};
+
+// Chase AI for both paddles of every match in a batch
+void ChaseBallBatch(BatchMatches const &batch, uint8_t *buttons)
+{
+    for (int i = 0; i < batch.Count(); i++)
+    {
+        float ballCenter = batch.ballY[i] + Ball_Height / 2.0f;
+        float paddleOneCenter = batch.paddleOneY[i] + Paddle_Height / 2.0f;
+        float paddleTwoCenter = batch.paddleTwoY[i] + Paddle_Height / 2.0f;
+
+        buttons[i] = static_cast<uint8_t>(
+            ((ballCenter < paddleOneCenter - Paddle_Height / 4.0f) << Buttons::PaddleOneUP) |
+            ((ballCenter > paddleOneCenter + Paddle_Height / 4.0f) << Buttons::PaddleOneDown) |
+            ((ballCenter < paddleTwoCenter - Paddle_Height / 4.0f) << Buttons::PaddleTwoUp) |
+            ((ballCenter > paddleTwoCenter + Paddle_Height / 4.0f) << Buttons::PaddleTwoDown));
+    }
+}
+
+// Intercept AI for every match in a batch: one SIMD solve per paddle
+// over all the lanes, then the same dead zone as InterceptBall
+void InterceptBatch(BatchMatches const &batch, uint8_t *buttons, Intercept *paddleOne, Intercept *paddleTwo)
+{
+    SolveIntercepts(batch.ballX, batch.ballY, batch.ballVX, batch.ballVY, BatchMatches::Paddle_One_X, batch.Count(), paddleOne);
+    SolveIntercepts(batch.ballX, batch.ballY, batch.ballVX, batch.ballVY, BatchMatches::Paddle_Two_X, batch.Count(), paddleTwo);
+
+    for (int i = 0; i < batch.Count(); i++)
+    {
+        float targetOne = paddleOne[i].time >= 0.0f ? paddleOne[i].y + Ball_Height / 2.0f : HEIGHT / 2.0f;
+        float targetTwo = paddleTwo[i].time >= 0.0f ? paddleTwo[i].y + Ball_Height / 2.0f : HEIGHT / 2.0f;
+        float paddleOneCenter = batch.paddleOneY[i] + Paddle_Height / 2.0f;
+        float paddleTwoCenter = batch.paddleTwoY[i] + Paddle_Height / 2.0f;
+
+        buttons[i] = static_cast<uint8_t>(
+            ((targetOne < paddleOneCenter - Paddle_Height / 4.0f) << Buttons::PaddleOneUP) |
+            ((targetOne > paddleOneCenter + Paddle_Height / 4.0f) << Buttons::PaddleOneDown) |
+            ((targetTwo < paddleTwoCenter - Paddle_Height / 4.0f) << Buttons::PaddleTwoUp) |
+            ((targetTwo > paddleTwoCenter + Paddle_Height / 4.0f) << Buttons::PaddleTwoDown));
+    }
+}
+
+// Every match in one BatchMatches, stepped for maxTicks ticks
+int RunBatch(MatchRunConfig const &config)
+{
+    BatchMatches batch(config.matches, config.seed);
+    vector<uint8_t> buttons(config.matches);
+    vector<Intercept> paddleOne(config.matches);
+    vector<Intercept> paddleTwo(config.matches);
+
+    vector<ScriptedInput> scripts;
+    if (config.input == InputMode::Scripted)
+    {
+        for (int i = 0; i < config.matches; i++)
+        {
+            scripts.emplace_back(SeedFor(config.seed ^ 1, i));
+        }
+    }
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (long tick = 0; tick < config.maxTicks; tick++)
+    {
+        if (config.input == InputMode::AI)
+        {
+            ChaseBallBatch(batch, buttons.data());
+        }
+        else if (config.input == InputMode::Intercept)
+        {
+            InterceptBatch(batch, buttons.data(), paddleOne.data(), paddleTwo.data());
+        }
+        else
+        {
+            for (int i = 0; i < config.matches; i++)
+            {
+                bool held[4];
+                scripts[i].Next(held);
+                buttons[i] = PackButtons(held);
+            }
+        }
+
+        batch.Step(config.tickDt, buttons.data());
+    }
+
+    auto stopTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(stopTime - startTime).count();
+
+    long long points = 0;
+    for (int i = 0; i < config.matches; i++)
+    {
+        points += batch.playerOneScore[i] + batch.playerTwoScore[i];
+    }
+
+    long long totalTicks = static_cast<long long>(config.matches) * config.maxTicks;
+
+    cout << "matches:        " << config.matches << '\n'
+         << "points scored:  " << points << '\n'
+         << "ticks:          " << totalTicks << '\n'
+         << "seconds:        " << seconds << '\n'
+         << "ticks/sec:      " << static_cast<double>(totalTicks) / seconds << '\n';
+
+    return 0;
+}
+
+// Every match played to the score limit (or maxTicks), spread over the
+// thread pool. Scripted input by default: neither AI ever misses, so their
+// matches would all run to maxTicks, and work stealing is there for
+// matches of uneven length.
+int RunParallel(MatchRunConfig const &config, int threads)
+{
+    WorkStealingPool pool(threads);
+
+    auto startTime = chrono::high_resolution_clock::now();
+    MatchRunStats stats = RunMatches(pool, config);
+    auto stopTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(stopTime - startTime).count();
+
+    cout << "threads:        " << pool.WorkerCount() << '\n'
+         << "rules:          " << (config.rules.IsStandard() ? "standard" : "runtime") << '\n'
+         << "matches:        " << stats.matches << '\n'
+         << "player one won: " << stats.playerOneWins << '\n'
+         << "player two won: " << stats.playerTwoWins << '\n'
+         << "points scored:  " << stats.points << '\n'
+         << "ticks:          " << stats.ticks << '\n'
+         << "seconds:        " << seconds << '\n'
+         << "ticks/sec:      " << static_cast<double>(stats.ticks) / seconds << '\n'
+         << "matches/sec:    " << stats.matches / seconds << '\n';
+
+    return 0;
+}
+
+// Play match 0 of the run (same seeds as RunMatches) and save its replay
+int RecordMatch(MatchRunConfig const &config, int tickRate, string const &path)
+{
+    Match match(SeedFor(config.seed, 0));
+    ScriptedInput script(SeedFor(config.seed, 1));
+    ReplayRecorder recorder(SeedFor(config.seed, 0), tickRate);
+    bool buttons[4] = {};
+
+    long ticks = 0;
+    while (ticks < config.maxTicks &&
+           match.playerOneScore < config.scoreLimit &&
+           match.playerTwoScore < config.scoreLimit)
+    {
+        if (config.input == InputMode::AI)
+        {
+            ChaseBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown]);
+            ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        }
+        else if (config.input == InputMode::Intercept)
+        {
+            InterceptBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown]);
+            InterceptBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        }
+        else
+        {
+            script.Next(buttons);
+        }
+
+        recorder.Record(PackButtons(buttons), match);
+        match.SetButtons(buttons);
+        match.Tick(config.tickDt);
+        ++ticks;
+    }
+
+    Replay replay = recorder.Finish();
+    if (!SaveReplay(path, replay))
+    {
+        return 1;
+    }
+
+    cout << "score:          " << match.playerOneScore << " - " << match.playerTwoScore << '\n'
+         << "ticks:          " << replay.tickCount << '\n'
+         << "replay bytes:   " << replay.runs.size() << " (+ header)\n"
+         << "bytes/sec:      " << replay.runs.size() * static_cast<double>(tickRate) / replay.tickCount << '\n';
+
+    return 0;
+}
+
+// Re-simulate a replay, config.matches times over to time it
+int PlayReplay(MatchRunConfig const &config, string const &path)
+{
+    ReplayReader reader;
+    if (!reader.Open(path))
+    {
+        return 1;
+    }
+
+    const float tickDt = 1000.0f / reader.TickRate();
+    Match match(reader.Seed());
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (int m = 0; m < config.matches; m++)
+    {
+        match = Match(reader.Seed());
+        ReplayPlayer player = reader.Player();
+        uint8_t mask;
+
+        while (player.Next(mask))
+        {
+            bool buttons[4];
+            UnpackButtons(mask, buttons);
+            match.SetButtons(buttons);
+            match.Tick(tickDt);
+        }
+    }
+
+    auto stopTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(stopTime - startTime).count();
+    double played = static_cast<double>(reader.TickCount()) * config.matches;
+
+    cout << "score:          " << match.playerOneScore << " - " << match.playerTwoScore << '\n'
+         << "ticks:          " << reader.TickCount() << '\n'
+         << "keyframes:      " << reader.KeyframeCount() << '\n'
+         << "ticks/sec:      " << played / seconds << '\n'
+         << "x real time:    " << played / reader.TickRate() / seconds << '\n';
+
+    return 0;
+}
+
+// Jump straight to one tick of a replay through the keyframe index
+int SeekReplay(string const &path, long tick)
+{
+    ReplayReader reader;
+    if (!reader.Open(path))
+    {
+        return 1;
+    }
+
+    // Seek would clamp it, and the report would claim a tick we never reached
+    if (tick > static_cast<long>(reader.TickCount()))
+    {
+        cout << "--seek " << tick << " is past the end of " << path << " (" << reader.TickCount() << " ticks)\n";
+        return 1;
+    }
+
+    Match match;
+
+    auto startTime = chrono::high_resolution_clock::now();
+    reader.Seek(static_cast<uint32_t>(tick), match);
+    auto stopTime = chrono::high_resolution_clock::now();
+
+    cout << "tick:           " << tick << " of " << reader.TickCount() << '\n'
+         << "score:          " << match.playerOneScore << " - " << match.playerTwoScore << '\n'
+         << "ball:           " << match.ball.position.x << ", " << match.ball.position.y << '\n'
+         << "seek ms:        " << chrono::duration<double, milli>(stopTime - startTime).count() << '\n';
+
+    return 0;
+}
+
+// Two rollback peers talking over real loopback sockets, with fake latency.
+// Time is simulated (one frame per loop) so the run is reproducible and
+// doesn't take real minutes; maxTicks is the number of frames to play.
+int RunNetplay(MatchRunConfig const &config, int tickRate, float rttMs, float jitterMs)
+{
+    const double frameMs = 1000.0 / tickRate;
+
+    UdpSocket sockets[2];
+    if (!sockets[0].Open() || !sockets[1].Open())
+    {
+        return 1;
+    }
+
+    RollbackSession sessions[2] = {
+        RollbackSession(0, config.seed, config.tickDt),
+        RollbackSession(1, config.seed, config.tickDt)};
+    LaggyLink links[2] = {
+        LaggyLink(sockets[0], sockets[1].Port(), rttMs, jitterMs, SeedFor(config.seed, 10)),
+        LaggyLink(sockets[1], sockets[0].Port(), rttMs, jitterMs, SeedFor(config.seed, 11))};
+    ScriptedInput scripts[2] = {ScriptedInput(SeedFor(config.seed, 20)), ScriptedInput(SeedFor(config.seed, 21))};
+
+    long long stalls = 0;
+    double worstFrameMs = 0.0;
+    double now = 0.0;
+
+    // Keep going until both sides have played every frame and heard every
+    // input from the other side
+    for (long loop = 0; loop < config.maxTicks * 4 + 10000; loop++)
+    {
+        bool done = true;
+
+        for (int p = 0; p < 2; p++)
+        {
+            RollbackSession &session = sessions[p];
+
+            uint8_t packet[256];
+            for (int size; (size = sockets[p].Receive(packet, sizeof(packet))) >= 0;)
+            {
+                session.ReadPacket(packet, size);
+            }
+
+            if (session.Frame() < config.maxTicks)
+            {
+                if (session.CanAdvance())
+                {
+                    bool buttons[4];
+                    scripts[p].Next(buttons);
+                    uint8_t input = static_cast<uint8_t>(buttons[2 * p] | (buttons[2 * p + 1] << 1));
+
+                    auto startTime = chrono::high_resolution_clock::now();
+                    session.AdvanceFrame(input);
+                    auto stopTime = chrono::high_resolution_clock::now();
+
+                    double ms = chrono::duration<double, milli>(stopTime - startTime).count();
+                    worstFrameMs = ms > worstFrameMs ? ms : worstFrameMs;
+                }
+                else
+                {
+                    ++stalls;
+                }
+            }
+
+            size_t size = session.BuildPacket(packet, sizeof(packet));
+            links[p].Send(now, packet, size);
+            links[p].Flush(now);
+
+            done = done && session.Frame() == config.maxTicks && session.ConfirmedFrame() == session.Frame();
+        }
+
+        if (done)
+        {
+            break;
+        }
+        now += frameMs;
+    }
+
+    GameState states[2];
+    for (int p = 0; p < 2; p++)
+    {
+        sessions[p].Synchronize();
+        sessions[p].CurrentMatch().Save(states[p]);
+    }
+    bool inSync = sessions[0].ConfirmedFrame() == config.maxTicks && sessions[1].ConfirmedFrame() == config.maxTicks &&
+                  memcmp(&states[0], &states[1], sizeof(GameState)) == 0;
+
+    for (int p = 0; p < 2; p++)
+    {
+        RollbackSession const &session = sessions[p];
+        cout << "peer " << p << ":         frame " << session.Frame()
+             << ", rollbacks " << session.rollbacks
+             << ", avg length " << (session.rollbacks ? static_cast<double>(session.resimulatedFrames) / session.rollbacks : 0.0)
+             << ", longest " << session.longestRollback << '\n';
+    }
+
+    cout << "rtt/jitter ms:  " << rttMs << " / " << jitterMs << '\n'
+         << "stalled frames: " << stalls << '\n'
+         << "worst frame ms: " << worstFrameMs << " (budget " << frameMs << ")\n"
+         << "score:          " << states[0].playerOneScore << " - " << states[0].playerTwoScore << '\n'
+         << "in sync:        " << (inSync ? "yes" : "NO") << '\n';
+
+    return inSync ? 0 : 1;
+}
+
+// One arena with lots of balls, maxTicks ticks, timing every tick
+int RunMultiball(MatchRunConfig const &config, int ballCount, bool ballCollisions)
+{
+    Arena arena(config.seed);
+    arena.AddStandardPaddles();
+    arena.ServeBalls(ballCount);
+    arena.ballCollisions = ballCollisions;
+
+    ScriptedInput script(SeedFor(config.seed, 1));
+
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+    long long narrowTests = 0;
+    long long pairTests = 0;
+    long long contacts = 0;
+
+    for (long tick = 0; tick < config.maxTicks; tick++)
+    {
+        bool buttons[4];
+        script.Next(buttons);
+        arena.SetButtons(buttons);
+
+        auto startTime = chrono::high_resolution_clock::now();
+        arena.Step(config.tickDt);
+        auto stopTime = chrono::high_resolution_clock::now();
+
+        double ms = chrono::duration<double, milli>(stopTime - startTime).count();
+        totalMs += ms;
+        worstMs = ms > worstMs ? ms : worstMs;
+        narrowTests += arena.narrowTests;
+        pairTests += arena.ballPairTests;
+        contacts += arena.ballContacts;
+    }
+
+    cout << "balls:          " << arena.BallCount() << '\n'
+         << "ticks:          " << config.maxTicks << '\n'
+         << "ms/tick:        " << totalMs / config.maxTicks << " (worst " << worstMs << ")\n"
+         << "paddle tests:   " << static_cast<double>(narrowTests) / config.maxTicks
+         << " per tick (vs " << arena.BallCount() * arena.PaddleCount() << " brute force)\n";
+
+    if (ballCollisions)
+    {
+        double n = static_cast<double>(arena.BallCount());
+        cout << "ball pairs:     " << static_cast<double>(pairTests) / config.maxTicks
+             << " tested per tick (vs " << n * (n - 1) / 2 << " brute force)\n"
+             << "ball contacts:  " << static_cast<double>(contacts) / config.maxTicks << " per tick\n";
+    }
+
+    cout << "score:          " << arena.playerOneScore << " - " << arena.playerTwoScore << '\n';
+
+    return 0;
+}
+
+// VecEnv steps with random agent actions; --input picks paddle two's AI
+// (scripted = random actions for both paddles)
+int RunEnv(MatchRunConfig const &config, int threads, int envCount)
+{
+    WorkStealingPool pool(threads);
+
+    EnvConfig envConfig;
+    envConfig.count = envCount;
+    envConfig.seed = config.seed;
+    envConfig.scoreLimit = config.scoreLimit;
+    envConfig.tickDt = config.tickDt;
+    envConfig.opponent = config.input == InputMode::AI          ? Opponent::Chase
+                         : config.input == InputMode::Intercept ? Opponent::Intercept
+                                                                : Opponent::Agent;
+    VecEnv env(envConfig, &pool);
+
+    vector<uint8_t> actions(envCount);
+    vector<float> observations(static_cast<size_t>(envCount) * Env_Observation_Size);
+    vector<float> rewards(envCount);
+    vector<uint8_t> dones(envCount);
+    Rng rng(SeedFor(config.seed, 1));
+
+    env.Reset(observations.data());
+
+    double rewardSum = 0.0;
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (long step = 0; step < config.maxTicks; step++)
+    {
+        // Up, down or nothing for both paddles, two bits each
+        for (int i = 0; i < envCount; i++)
+        {
+            uint32_t bits = rng.NextU32();
+            actions[i] = static_cast<uint8_t>((bits & 0x3) == 0x3 ? bits & 0xD : bits & 0xF);
+        }
+
+        env.Step(actions.data(), observations.data(), rewards.data(), dones.data());
+
+        for (int i = 0; i < envCount; i++)
+        {
+            rewardSum += rewards[i];
+        }
+    }
+
+    auto stopTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(stopTime - startTime).count();
+    long long steps = static_cast<long long>(envCount) * config.maxTicks;
+
+    cout << "threads:        " << pool.WorkerCount() << '\n'
+         << "environments:   " << envCount << '\n'
+         << "steps:          " << steps << '\n'
+         << "episodes:       " << env.Episodes() << '\n'
+         << "reward sum:     " << rewardSum << '\n'
+         << "seconds:        " << seconds << '\n'
+         << "steps/sec:      " << static_cast<double>(steps) / seconds << '\n';
+
+    return 0;
+}
+
+// Renders a chase-vs-chase match into stacked pixel observations every
+// tick and reports how many frames a second one core makes
+int RunPixels(MatchRunConfig const &config, int width, int height, int stackSize, string const &framePath)
+{
+    Match match(config.seed);
+    PixelRenderer renderer(width, height);
+    int frameBytes = width * height;
+
+    FrameStack stack(stackSize, frameBytes);
+    vector<uint8_t> observation(static_cast<size_t>(stackSize) * frameBytes);
+
+    renderer.Render(match, observation.data());
+    stack.Fill(observation.data());
+
+    long frames = 0;
+    uint64_t checksum = 0;
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (long tick = 0; tick < config.maxTicks; tick++)
+    {
+        bool buttons[4] = {};
+        ChaseBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown]);
+        ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        match.SetButtons(buttons);
+        match.Tick(config.tickDt);
+
+        renderer.Render(match, stack.Next());
+        stack.Write(observation.data());
+        frames++;
+
+        // Keeps the work from being optimized away, and shows two runs drew the same
+        checksum = checksum * 31 + observation[(tick * 7919) % observation.size()];
+    }
+
+    auto stopTime = chrono::high_resolution_clock::now();
+    double seconds = chrono::duration<double>(stopTime - startTime).count();
+
+    cout << "frame:          " << width << "x" << height << " x " << stackSize << " stacked\n"
+         << "frames:         " << frames << '\n'
+         << "checksum:       " << checksum << '\n'
+         << "seconds:        " << seconds << '\n'
+         << "frames/sec:     " << static_cast<double>(frames) / seconds << '\n'
+         << "score:          " << match.playerOneScore << " - " << match.playerTwoScore << '\n';
+
+    if (!framePath.empty())
+    {
+        ofstream file(framePath, ios::binary);
+        if (!file)
+        {
+            cout << "Can't write " << framePath << '\n';
+            return 1;
+        }
+        file << "P5\n" << width << ' ' << height << "\n255\n";
+        file.write(reinterpret_cast<char const *>(observation.data()) + static_cast<size_t>(stackSize - 1) * frameBytes, frameBytes);
+    }
+
+    return 0;
+}
+
+// The digit font blown up to score size (8 px cells, 40 px tall like the
+// TTF), one byte per pixel, as a stand-in for the glyph surfaces main() blits
+static vector<uint8_t> DigitMask(int digit, int cell)
+{
+    int maskWidth = Digit_Columns * cell;
+    vector<uint8_t> mask(static_cast<size_t>(maskWidth) * Digit_Rows * cell);
+    for (int y = 0; y < Digit_Rows * cell; y++)
+    {
+        for (int x = 0; x < maskWidth; x++)
+        {
+            mask[y * maskWidth + x] = (Digit_Font[digit] >> ((y / cell) * Digit_Columns + x / cell)) & 1;
+        }
+    }
+    return mask;
+}
+
+// Draws main()'s full 1280x720 scene for every tick of a chase-vs-chase
+// match: redrawn whole with AVX2 spans and without, then only the dirty
+// rects (checked against a full redraw every frame)
+int RunRaster(MatchRunConfig const &config)
+{
+    const int cell = 8;
+    vector<vector<uint8_t>> digits;
+    for (int d = 0; d < 10; d++)
+    {
+        digits.push_back(DigitMask(d, cell));
+    }
+
+    auto buildScene = [&](Match const &match, Scene &scene) {
+        scene.boxes = {
+            {static_cast<int>(match.ball.position.x), static_cast<int>(match.ball.position.y), Ball_Width, Ball_Height},
+            {static_cast<int>(match.paddle1.position.x), static_cast<int>(match.paddle1.position.y), Paddle_Width, Paddle_Height},
+            {static_cast<int>(match.paddle2.position.x), static_cast<int>(match.paddle2.position.y), Paddle_Width, Paddle_Height},
+        };
+
+        int scores[2] = {match.playerOneScore % 10, match.playerTwoScore % 10};
+        int scoreX[2] = {WIDTH / 4, WIDTH * 3 / 4};
+        scene.glyphs.clear();
+        for (int p = 0; p < 2; p++)
+        {
+            Glyph glyph;
+            glyph.mask = digits[scores[p]].data();
+            glyph.x = scoreX[p];
+            glyph.y = 20;
+            glyph.width = glyph.pitch = Digit_Columns * cell;
+            glyph.height = Digit_Rows * cell;
+            scene.glyphs.push_back(glyph);
+        }
+    };
+
+    auto stepMatch = [&](Match &match) {
+        bool buttons[4] = {};
+        ChaseBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown]);
+        ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+        match.SetButtons(buttons);
+        match.Tick(config.tickDt);
+    };
+
+    Framebuffer framebuffer(WIDTH, HEIGHT);
+    Scene scene;
+    cout << "frame:          " << WIDTH << "x" << HEIGHT << " ARGB\n";
+
+    bool const kernels[2] = {false, true};
+    for (bool avx2 : kernels)
+    {
+        if (avx2 && !HasAVX2())
+        {
+            continue;
+        }
+        UseAVX2Spans(avx2);
+
+        Match match(config.seed);
+        uint64_t checksum = 0;
+        auto startTime = chrono::high_resolution_clock::now();
+
+        for (long tick = 0; tick < config.maxTicks; tick++)
+        {
+            stepMatch(match);
+            buildScene(match, scene);
+            DrawScene(framebuffer, scene);
+
+            checksum = checksum * 31 + framebuffer.Pixels()[(tick * 7919) % (WIDTH * HEIGHT)];
+        }
+
+        auto stopTime = chrono::high_resolution_clock::now();
+        double seconds = chrono::duration<double>(stopTime - startTime).count();
+
+        cout << (avx2 ? "avx2 spans:     " : "sse2 spans:     ")
+             << seconds * 1000.0 / config.maxTicks << " ms/frame, "
+             << static_cast<double>(config.maxTicks) / seconds << " frames/sec (checksum " << checksum << ")\n";
+    }
+    UseAVX2Spans(true);
+
+    // Dirty rects: redraw only what changed, then compare with a full
+    // redraw of the same scene (outside the timing)
+    Framebuffer reference(WIDTH, HEIGHT);
+    DamageList damage(WIDTH, HEIGHT);
+    Scene previous;
+    Match match(config.seed);
+    long long damagedPixels = 0;
+    long mismatches = 0;
+    double seconds = 0.0;
+
+    for (long tick = 0; tick < config.maxTicks; tick++)
+    {
+        stepMatch(match);
+        buildScene(match, scene);
+
+        auto startTime = chrono::high_resolution_clock::now();
+
+        damage.Clear();
+        if (tick == 0)
+        {
+            damage.AddAll();
+        }
+        else
+        {
+            damage.AddChanges(previous, scene);
+        }
+
+        for (Rect const &rect : damage.Rects())
+        {
+            framebuffer.SetClip(rect);
+            DrawScene(framebuffer, scene);
+        }
+        framebuffer.ResetClip();
+
+        auto stopTime = chrono::high_resolution_clock::now();
+        seconds += chrono::duration<double>(stopTime - startTime).count();
+        damagedPixels += damage.Area();
+        swap(previous, scene);
+
+        DrawScene(reference, previous);
+        mismatches += memcmp(framebuffer.Pixels(), reference.Pixels(), sizeof(uint32_t) * WIDTH * HEIGHT) != 0;
+    }
+
+    double perFrame = static_cast<double>(damagedPixels) / config.maxTicks;
+    cout << "dirty rects:    " << seconds * 1000.0 / config.maxTicks << " ms/frame, "
+         << perFrame << " px/frame (" << 100.0 * perFrame / (WIDTH * HEIGHT) << "% of a full redraw)\n"
+         << "mismatches:     " << mismatches << " frames\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Three seconds of frames paced to fps, each doing a frame's worth of
+// match ticks, to see how exact the pacer is and what it costs
+int RunPacing(MatchRunConfig const &config, double fps)
+{
+    FramePacer pacer(PacingMode::TargetFps, fps);
+    Match match(config.seed);
+    double tickBank = 0.0;
+
+    long frames = static_cast<long>(fps * 3.0);
+    clock_t cpuStart = clock();
+    auto startTime = chrono::steady_clock::now();
+
+    for (long frame = 0; frame <= frames; frame++)
+    {
+        for (tickBank += 1000.0 / fps; tickBank >= config.tickDt; tickBank -= config.tickDt)
+        {
+            bool buttons[4] = {};
+            ChaseBall(match.ball, match.paddle1, buttons[Buttons::PaddleOneUP], buttons[Buttons::PaddleOneDown]);
+            ChaseBall(match.ball, match.paddle2, buttons[Buttons::PaddleTwoUp], buttons[Buttons::PaddleTwoDown]);
+            match.SetButtons(buttons);
+            match.Tick(config.tickDt);
+        }
+        pacer.EndFrame();
+    }
+
+    // clock() is process CPU time here (on Windows' C runtime it'd be wall time)
+    double cpuSeconds = static_cast<double>(clock() - cpuStart) / CLOCKS_PER_SEC;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+
+    pacer.Report(cout);
+    cout << "cpu:            " << 100.0 * cpuSeconds / seconds << "% of one core\n";
+
+    return 0;
+}
+
+// Self-check: every SIMD kernel against its scalar reference on random
+// input, with counts that leave tails and starts that aren't aligned
+
+const int Self_Check_Rounds = 4000;
+const int Self_Check_Max_Count = 67;
+const int Self_Check_Lanes = Self_Check_Max_Count + 8;
+
+// Bit for bit, except that any NaN matches any NaN
+static bool SameFloat(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0 || (a != a && b != b);
+}
+
+// Uniform in [low, high), but every fourth one a whole pixel so edges get
+// hit exactly
+static float CheckFloat(Rng &rng, float low, float high)
+{
+    float value = low + (high - low) * rng.NextFloat();
+    return rng.NextU32() % 4 == 0 ? floorf(value) : value;
+}
+
+static bool SameContacts(Contact const *a, Contact const *b, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (a[i].type != b[i].type || !SameFloat(a[i].penetration, b[i].penetration))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static long long CheckCollisionKernels(Rng &rng, bool avx2)
+{
+    vector<float> ballX(Self_Check_Lanes), ballY(Self_Check_Lanes), ballVX(Self_Check_Lanes), paddleY(Self_Check_Lanes);
+    vector<Contact> expected(Self_Check_Lanes), got(Self_Check_Lanes);
+    long long lanes = 0;
+    long long paddleMismatches = 0;
+    long long wallMismatches = 0;
+
+    for (int round = 0; round < Self_Check_Rounds; round++)
+    {
+        int count = static_cast<int>(rng.NextU32() % (Self_Check_Max_Count + 1));
+        int start = static_cast<int>(rng.NextU32() % 8);
+        float paddleX = rng.NextU32() % 2 ? BatchMatches::Paddle_One_X : BatchMatches::Paddle_Two_X;
+
+        // Balls in and around the paddle's box and the field's edges
+        for (int i = start; i < start + count; i++)
+        {
+            paddleY[i] = CheckFloat(rng, 0.0f, HEIGHT - Paddle_Height);
+            ballX[i] = CheckFloat(rng, paddleX - 2 * Ball_Width, paddleX + Paddle_Width + Ball_Width);
+            ballY[i] = CheckFloat(rng, paddleY[i] - 2 * Ball_Height, paddleY[i] + Paddle_Height + Ball_Height);
+
+            // Or touching an edge of the paddle or of one of its zones
+            const float xEdges[] = {paddleX - Ball_Width, paddleX + Paddle_Width};
+            const float yEdges[] = {-Ball_Height, Paddle_Height / 3.0f - Ball_Height,
+                                    2.0f * Paddle_Height / 3.0f - Ball_Height, Paddle_Height};
+            if (rng.NextU32() % 4 == 0)
+            {
+                ballX[i] = xEdges[rng.NextU32() % 2];
+            }
+            if (rng.NextU32() % 4 == 0)
+            {
+                // Whole pixels, so the sums come out exact
+                paddleY[i] = floorf(paddleY[i]);
+                ballY[i] = paddleY[i] + yEdges[rng.NextU32() % 4];
+            }
+            int direction = static_cast<int>(rng.NextU32() % 3) - 1;
+            ballVX[i] = direction * Ball_Speed;
+        }
+        lanes += count;
+
+        CheckPaddleCollisionsScalar(&ballX[start], &ballY[start], &ballVX[start], paddleX, &paddleY[start], count, &expected[start]);
+        CheckPaddleCollisionsSSE2(&ballX[start], &ballY[start], &ballVX[start], paddleX, &paddleY[start], count, &got[start]);
+        paddleMismatches += !SameContacts(&expected[start], &got[start], count);
+        if (avx2)
+        {
+            CheckPaddleCollisionsAVX2(&ballX[start], &ballY[start], &ballVX[start], paddleX, &paddleY[start], count, &got[start]);
+            paddleMismatches += !SameContacts(&expected[start], &got[start], count);
+        }
+
+        for (int i = start; i < start + count; i++)
+        {
+            ballX[i] = CheckFloat(rng, -2.0f * Ball_Width, WIDTH + Ball_Width);
+            ballY[i] = CheckFloat(rng, -2.0f * Ball_Height, HEIGHT + Ball_Height);
+        }
+
+        CheckWallCollisionsScalar(&ballX[start], &ballY[start], count, &expected[start]);
+        CheckWallCollisionsSSE2(&ballX[start], &ballY[start], count, &got[start]);
+        wallMismatches += !SameContacts(&expected[start], &got[start], count);
+        if (avx2)
+        {
+            CheckWallCollisionsAVX2(&ballX[start], &ballY[start], count, &got[start]);
+            wallMismatches += !SameContacts(&expected[start], &got[start], count);
+        }
+    }
+
+    cout << "paddle hits:    " << lanes << " balls, " << paddleMismatches << " mismatched batches\n"
+         << "wall hits:      " << lanes << " balls, " << wallMismatches << " mismatched batches\n";
+    return paddleMismatches + wallMismatches;
+}
+
+static bool SameIntercepts(Intercept const *a, Intercept const *b, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!SameFloat(a[i].y, b[i].y) || !SameFloat(a[i].time, b[i].time))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static long long CheckInterceptKernels(Rng &rng, bool avx2)
+{
+    const float nan = nanf("");
+    vector<float> ballX(Self_Check_Lanes), ballY(Self_Check_Lanes), ballVX(Self_Check_Lanes), ballVY(Self_Check_Lanes);
+    vector<Intercept> expected(Self_Check_Lanes), got(Self_Check_Lanes);
+    long long lanes = 0;
+    long long mismatches = 0;
+
+    for (int round = 0; round < Self_Check_Rounds; round++)
+    {
+        int count = static_cast<int>(rng.NextU32() % (Self_Check_Max_Count + 1));
+        int start = static_cast<int>(rng.NextU32() % 8);
+        float paddleX = rng.NextU32() % 2 ? BatchMatches::Paddle_One_X : BatchMatches::Paddle_Two_X;
+
+        // Either way across the field, sometimes standing still in x or y,
+        // sometimes NaN
+        for (int i = start; i < start + count; i++)
+        {
+            ballX[i] = CheckFloat(rng, 0.0f, WIDTH - Ball_Width);
+            ballY[i] = CheckFloat(rng, 0.0f, HEIGHT - Ball_Height);
+            ballVX[i] = CheckFloat(rng, -2.0f * Ball_Speed, 2.0f * Ball_Speed);
+            ballVY[i] = CheckFloat(rng, -2.0f * Ball_Speed, 2.0f * Ball_Speed);
+
+            switch (rng.NextU32() % 8)
+            {
+            case 0:
+                ballVX[i] = 0.0f;
+                break;
+            case 1:
+                ballVY[i] = 0.0f;
+                break;
+            case 2:
+                ballVX[i] = nan;
+                break;
+            case 3:
+                ballVY[i] = nan;
+                break;
+            case 4:
+                ballY[i] = nan;
+                break;
+            }
+        }
+        lanes += count;
+
+        SolveInterceptsScalar(&ballX[start], &ballY[start], &ballVX[start], &ballVY[start], paddleX, count, &expected[start]);
+        SolveInterceptsSSE2(&ballX[start], &ballY[start], &ballVX[start], &ballVY[start], paddleX, count, &got[start]);
+        mismatches += !SameIntercepts(&expected[start], &got[start], count);
+        if (avx2)
+        {
+            SolveInterceptsAVX2(&ballX[start], &ballY[start], &ballVX[start], &ballVY[start], paddleX, count, &got[start]);
+            mismatches += !SameIntercepts(&expected[start], &got[start], count);
+        }
+    }
+
+    cout << "intercepts:     " << lanes << " balls, " << mismatches << " mismatched batches\n";
+    return mismatches;
+}
+
+// Spans long enough for AVX2's aligning prologue (64+ pixels), with guard
+// pixels either side that must come out untouched
+static long long CheckSpanKernels(Rng &rng, bool avx2)
+{
+    const int maxCount = 200;
+    const int guard = 16;
+    vector<uint32_t> original(maxCount + 2 * guard), expected(original.size()), got(original.size());
+    vector<uint8_t> mask(maxCount + guard);
+    long long pixels = 0;
+    long long fillMismatches = 0;
+    long long blendMismatches = 0;
+
+    for (int round = 0; round < Self_Check_Rounds; round++)
+    {
+        int count = static_cast<int>(rng.NextU32() % (maxCount + 1));
+        int start = static_cast<int>(rng.NextU32() % guard);
+        int maskStart = static_cast<int>(rng.NextU32() % guard);
+        uint32_t color = rng.NextU32();
+
+        for (uint32_t &pixel : original)
+        {
+            pixel = rng.NextU32();
+        }
+        // Mostly fully off or on, like glyph masks
+        for (uint8_t &coverage : mask)
+        {
+            uint32_t kind = rng.NextU32() % 4;
+            coverage = kind == 0 ? 0 : (kind == 1 ? 255 : static_cast<uint8_t>(rng.NextU32()));
+        }
+        pixels += count;
+
+        auto check = [&](void (*span)(uint32_t *, int, uint32_t)) {
+            got = original;
+            span(&got[guard + start], count, color);
+            return got != expected;
+        };
+        expected = original;
+        FillSpanScalar(&expected[guard + start], count, color);
+        fillMismatches += check(FillSpanSSE2);
+        if (avx2)
+        {
+            fillMismatches += check(FillSpanAVX2);
+        }
+
+        expected = original;
+        BlendMaskSpanScalar(&expected[guard + start], &mask[maskStart], count, color);
+        if (avx2)
+        {
+            got = original;
+            BlendMaskSpanAVX2(&got[guard + start], &mask[maskStart], count, color);
+            blendMismatches += got != expected;
+        }
+    }
+
+    cout << "span fills:     " << pixels << " pixels, " << fillMismatches << " mismatched spans\n"
+         << "mask blends:    " << (avx2 ? pixels : 0) << " pixels, " << blendMismatches << " mismatched spans\n";
+    return fillMismatches + blendMismatches;
+}
+
+// Exits 1 if any kernel disagrees with scalar; the AVX2 ones are only
+// checked on CPUs that have it
+int RunSelfCheck(MatchRunConfig const &config)
+{
+    Rng rng(SeedFor(config.seed, 30));
+    bool avx2 = HasAVX2();
+    cout << "kernels:        scalar, SSE2" << (avx2 ? ", AVX2" : " (AVX2 not available here)") << '\n';
+
+    long long mismatches = 0;
+    mismatches += CheckCollisionKernels(rng, avx2);
+    mismatches += CheckInterceptKernels(rng, avx2);
+    mismatches += CheckSpanKernels(rng, avx2);
+
+    cout << "self-check:     " << (mismatches == 0 ? "passed" : "FAILED") << '\n';
+    return mismatches == 0 ? 0 : 1;
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options)
+{
+    MatchRunConfig &run = options.run;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (strcmp(argv[i], "--matches") == 0 && hasValue)
+        {
+            run.matches = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--score-limit") == 0 && hasValue)
+        {
+            run.scoreLimit = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-ticks") == 0 && hasValue)
+        {
+            run.maxTicks = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tick-rate") == 0 && hasValue)
+        {
+            options.tickRate = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            run.seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            options.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && hasValue)
+        {
+            options.recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--play") == 0 && hasValue)
+        {
+            options.playPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seek") == 0 && hasValue)
+        {
+            options.seekTick = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--netplay") == 0)
+        {
+            options.netplay = true;
+        }
+        else if (strcmp(argv[i], "--rtt") == 0 && hasValue)
+        {
+            options.rttMs = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--jitter") == 0 && hasValue)
+        {
+            options.jitterMs = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--multiball") == 0 && hasValue)
+        {
+            options.balls = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ball-collisions") == 0)
+        {
+            options.ballCollisions = true;
+        }
+        else if (strcmp(argv[i], "--width") == 0 && hasValue)
+        {
+            run.rules.width = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--height") == 0 && hasValue)
+        {
+            run.rules.height = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--ball-size") == 0 && hasValue)
+        {
+            run.rules.ballWidth = run.rules.ballHeight = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--paddle-height") == 0 && hasValue)
+        {
+            run.rules.paddleHeight = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--ball-speed") == 0 && hasValue)
+        {
+            run.rules.ballSpeed = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--paddle-speed") == 0 && hasValue)
+        {
+            run.rules.paddleSpeed = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--env") == 0 && hasValue)
+        {
+            options.envs = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--pixels") == 0 && hasValue)
+        {
+            // WIDTHxHEIGHT
+            if (sscanf(argv[++i], "%dx%d", &options.pixelWidth, &options.pixelHeight) != 2 ||
+                options.pixelWidth <= 0 || options.pixelHeight <= 0)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--frame-stack") == 0 && hasValue)
+        {
+            options.frameStack = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--frame") == 0 && hasValue)
+        {
+            options.framePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--pace") == 0 && hasValue)
+        {
+            options.paceFps = atof(argv[++i]);
+            if (options.paceFps <= 0.0)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && hasValue)
+        {
+            options.profilePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--self-check") == 0)
+        {
+            options.selfCheck = true;
+        }
+        else if (strcmp(argv[i], "--raster") == 0)
+        {
+            options.raster = true;
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+        {
+            options.batch = true;
+        }
+        else if (strcmp(argv[i], "--input") == 0 && hasValue)
+        {
+            options.inputGiven = true;
+            ++i;
+            if (strcmp(argv[i], "ai") == 0)
+            {
+                run.input = InputMode::AI;
+            }
+            else if (strcmp(argv[i], "intercept") == 0)
+            {
+                run.input = InputMode::Intercept;
+            }
+            else if (strcmp(argv[i], "scripted") == 0)
+            {
+                run.input = InputMode::Scripted;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    if (options.tickRate <= 0 || !run.rules.IsValid())
+    {
+        return false;
+    }
+    run.tickDt = 1000.0f / options.tickRate;
+
+    return run.matches > 0 && run.scoreLimit > 0 && run.maxTicks > 0 && options.threads >= 0 &&
+           options.frameStack > 0;
+}
+
+static int Run(Options const &options)
+{
+    // Matches played to a score need someone to miss
+    MatchRunConfig matchRun = options.run;
+    if (!options.inputGiven)
+    {
+        matchRun.input = InputMode::Scripted;
+    }
+
+    if (!options.recordPath.empty())
+    {
+        return RecordMatch(matchRun, options.tickRate, options.recordPath);
+    }
+    if (!options.playPath.empty() && options.seekTick >= 0)
+    {
+        return SeekReplay(options.playPath, options.seekTick);
+    }
+    if (!options.playPath.empty())
+    {
+        return PlayReplay(options.run, options.playPath);
+    }
+    if (options.balls > 0)
+    {
+        return RunMultiball(options.run, options.balls, options.ballCollisions);
+    }
+    if (options.envs > 0)
+    {
+        return RunEnv(options.run, options.threads, options.envs);
+    }
+    if (options.pixelWidth > 0)
+    {
+        return RunPixels(options.run, options.pixelWidth, options.pixelHeight, options.frameStack, options.framePath);
+    }
+    if (options.paceFps > 0.0)
+    {
+        return RunPacing(options.run, options.paceFps);
+    }
+    if (options.raster)
+    {
+        return RunRaster(options.run);
+    }
+    if (options.selfCheck)
+    {
+        return RunSelfCheck(options.run);
+    }
+    if (options.netplay)
+    {
+        return RunNetplay(options.run, options.tickRate, options.rttMs, options.jitterMs);
+    }
+    if (options.batch)
+    {
+        return RunBatch(options.run);
+    }
+
+    return RunParallel(matchRun, options.threads);
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        cout << "Usage: " << argv[0]
+             << " [--matches N] [--score-limit N] [--max-ticks N] [--tick-rate HZ]"
+                " [--seed N] [--input ai|intercept|scripted] [--threads N] [--batch]"
+                " [--record FILE] [--play FILE [--seek TICK]]"
+                " [--netplay [--rtt MS] [--jitter MS]] [--multiball BALLS [--ball-collisions]] [--env ENVS]"
+                " [--pixels WxH [--frame-stack N] [--frame FILE.pgm]] [--raster] [--pace FPS] [--self-check]"
+                " [--profile FILE.csv|.json]"
+                " [--width PX] [--height PX] [--ball-size PX] [--paddle-height PX]"
+                " [--ball-speed PX_PER_MS] [--paddle-speed PX_PER_MS]\n";
+        return 1;
+    }
+
+    // Replays, netplay and the batch and arena engines are standard-only
+    bool plainRun = options.recordPath.empty() && options.playPath.empty() &&
+                    options.balls == 0 && options.envs == 0 && options.pixelWidth == 0 && !options.raster && !options.selfCheck && options.paceFps == 0.0 && !options.netplay && !options.batch;
+    if (!plainRun && !options.run.rules.IsStandard())
+    {
+        cout << "Rule options only apply to plain match runs\n";
+        return 1;
+    }
+
+    int result = Run(options);
+
+    if (Profiling)
+    {
+        PrintProfile(cout);
+        if (!options.profilePath.empty())
+        {
+            WriteProfile(options.profilePath);
+        }
+    }
+    else if (!options.profilePath.empty())
+    {
+        cout << "Built without PONG_PROFILE, no timings to save (make headless PROFILE=1)\n";
+    }
+
+    return result;
+}
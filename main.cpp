@@ -22,381 +22,388 @@ WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
 OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
-using namespace std;
+#include "game/framebuffer.h"
+#include "game/multiball.h"
+#include "game/net.h"
+#include "game/pacing.h"
+#include "game/pong.h"
+#include "game/profile.h"
+#include "game/replay.h"
+#include "game/rollback.h"
+#include "game/scene.h"
+#include "render/drawlist.h"
+#include "render/glyphs.h"
+#include "render/layer.h"
 
-const int WIDTH = 1280;
-const int HEIGHT = 720;
-const int Ball_Width = 15;
-const int Ball_Height = 15;
-const int Paddle_Width = 10;
-const int Paddle_Height = 80;
-const float Paddle_Speed = 1.0f;
-const float Ball_Speed = 0.8f;
+using namespace std;
 
-enum Buttons
-{
-    PaddleOneUP = 0,
-    PaddleOneDown,
-    PaddleTwoUp,
-    PaddleTwoDown,
-};
+// Upper bound on ticks run per frame so a long hitch can't snowball
+const int Max_Ticks_Per_Frame = 8;
 
-enum class CollisionType
+SDL_Rect BallRect(Ball const &ball, float alpha)
 {
-    None,
-    Top,
-    Middle,
-    Bottom,
-    Left,
-    Right
-};
+    Vec2 drawPosition = Lerp(ball.previousPosition, ball.position, alpha);
 
-struct Contact
-{
-    CollisionType type;
-    float penetration;
-};
+    SDL_Rect rect{};
+    rect.x = static_cast<int>(drawPosition.x);
+    rect.y = static_cast<int>(drawPosition.y);
+    rect.w = Ball_Width;
+    rect.h = Ball_Height;
+    return rect;
+}
 
-class Vec2
+SDL_Rect PaddleRect(Paddle const &paddle, float alpha)
 {
-public:
-    Vec2() : x(0.0f), y(0.0f) {} // Use constructor to initialize x and y
+    Vec2 drawPosition = Lerp(paddle.previousPosition, paddle.position, alpha);
 
-    Vec2(float x, float y) : x(x), y(y) {}
-
-    Vec2 operator+(Vec2 const &rhs) // rhs = Right Hand Side
-    {
-        return Vec2(x + rhs.x, y + rhs.y);
-    }
-    Vec2 &operator+=(Vec2 const &rhs)
-    {
-        x += rhs.x;
-        y += rhs.y;
-        return *this;
-    }
+    SDL_Rect rect{};
+    rect.x = static_cast<int>(drawPosition.x);
+    rect.y = static_cast<int>(drawPosition.y);
+    rect.w = Paddle_Width;
+    rect.h = Paddle_Height;
+    return rect;
+}
 
-    Vec2 operator*(float rhs)
+// Where the software path draws: straight into the window surface when
+// it's 32-bit XRGB (it usually is), else into offscreen and converted
+Framebuffer SoftwareTarget(SDL_Surface *surface, Framebuffer &offscreen)
+{
+    if (surface->format->format == SDL_PIXELFORMAT_RGB888 || surface->format->format == SDL_PIXELFORMAT_ARGB8888)
     {
-        return Vec2(x * rhs, y * rhs);
+        return Framebuffer(static_cast<uint32_t *>(surface->pixels), min(surface->w, WIDTH), min(surface->h, HEIGHT), surface->pitch);
     }
-    float x, y;
-};
+    return Framebuffer(offscreen.Pixels(), min(surface->w, offscreen.Width()), min(surface->h, offscreen.Height()), offscreen.Pitch());
+}
 
-class Ball
+// A score drawn from the glyph atlas; changing it only rewrites a few
+// characters
+class PlayerScores
 {
 public:
-    Ball(Vec2 position, Vec2 velocity)
-        : position(position), velocity(velocity)
+    PlayerScores(Vec2 position, GlyphAtlas const &glyphs)
+        : glyphs(glyphs), x(static_cast<int>(position.x)), y(static_cast<int>(position.y))
     {
-        rect.x = static_cast<int>(position.x);
-        rect.y = static_cast<int>(position.y);
-        rect.w = Ball_Width;
-        rect.h = Ball_Height;
+        SetScore(0);
     }
 
-    void Draw(SDL_Renderer *renderer)
+    void SetScore(int score)
     {
-        rect.x = static_cast<int>(position.x);
-        rect.y = static_cast<int>(position.y);
-
-        SDL_RenderFillRect(renderer, &rect);
+        // Digits backwards into the end of the buffer
+        char *digit = text + sizeof(text) - 1;
+        *digit = '\0';
+        unsigned value = score < 0 ? 0u : static_cast<unsigned>(score);
+        do
+        {
+            *--digit = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        start = digit;
     }
 
-    void update(float dt)
+    void Draw(DrawList &drawList) const
     {
-        position += velocity * dt;
+        glyphs.DrawText(drawList, start, x, y);
     }
 
-    void CollisionWithPaddle(Contact const &contact)
+    // Software path
+    void AddGlyphs(vector<Glyph> &out) const
     {
-        position.x += contact.penetration;
-        velocity.x = -velocity.x;
+        glyphs.AddText(out, start, x, y);
+    }
+
+private:
+    GlyphAtlas const &glyphs;
+    int x;
+    int y;
+    char text[12];
+    char const *start = text;
+};
 
-        if (contact.type == CollisionType::Top)
+int main(int argc, char *argv[])
+{
+    int tickRate = Tick_Rate;
+    uint64_t seed = 1;
+    const char *recordPath = nullptr; // Save a replay of this game on exit
+    const char *replayPath = nullptr; // Watch a replay instead of playing
+    int ballCount = 1; // More than one plays the multi-ball arena instead
+    bool software = false; // Draw on the CPU into the window surface, no SDL_Renderer
+    PacingMode pacing = PacingMode::VSync;
+    double targetFps = 0.0; // 0 = the display's refresh rate
+    const char *profilePath = nullptr; // Save the per-phase timings here (PONG_PROFILE builds)
+    int hostPort = 0; // Netplay on this machine: the host plays paddle one on this port,
+    int joinPort = 0; // the joiner paddle two on the next one up (same --seed and --tick-rate)
+    float rttMs = 0.0f; // Fake network lag for netplay
+    float jitterMs = 0.0f;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
         {
-            velocity.y = -0.75f * Ball_Speed;
+            tickRate = atoi(argv[++i]);
         }
-        else if (contact.type == CollisionType::Bottom)
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
         {
-            velocity.y = 0.75f * Ball_Speed;
+            seed = strtoull(argv[++i], nullptr, 10);
         }
-    }
-
-    void CollideWithWall(Contact const &contact)
-    {
-        if ((contact.type == CollisionType::Top) || (contact.type == CollisionType::Bottom))
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
         {
-            position.y += contact.penetration;
-            velocity.y = -velocity.y;
+            recordPath = argv[++i];
         }
-        else if (contact.type == CollisionType::Left || contact.type == CollisionType::Right)
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
         {
-            // Reset ball position to the center
-            position.x = WIDTH / 2.0f;
-            position.y = HEIGHT / 2.0f;
-
-            // Randomize Y-axis velocity after reset
-            velocity.x = (contact.type == CollisionType::Left) ? Ball_Speed : -Ball_Speed;
-            velocity.y = ((rand() % 2) == 0 ? 1 : -1) * (0.5f + static_cast<float>(rand()) / RAND_MAX * 0.5f) * Ball_Speed;
+            replayPath = argv[++i];
         }
-    }
-
-    Vec2 position;
-    Vec2 velocity;
-    SDL_Rect rect{};
-};
-
-class Paddle
-{
-public:
-    Paddle(Vec2 position, Vec2 velocity) : position(position), velocity(velocity)
-    {
-        rect.x = static_cast<int>(position.x);
-        rect.y = static_cast<int>(position.y);
-        rect.w = Paddle_Width;
-        rect.h = Paddle_Height;
-    }
-
-    void Draw(SDL_Renderer *renderer)
-    {
-        rect.y = static_cast<int>(position.y);
-
-        SDL_RenderFillRect(renderer, &rect);
-    }
-
-    // Update paddle position
-    void update(float dt)
-    {
-        position += velocity * dt;
-
-        if (position.y < 0)
+        else if (strcmp(argv[i], "--balls") == 0 && i + 1 < argc)
+        {
+            ballCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--software") == 0)
+        {
+            software = true;
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            pacing = PacingMode::TargetFps;
+            targetFps = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+        {
+            hostPort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc)
+        {
+            joinPort = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--rtt") == 0 && i + 1 < argc)
+        {
+            rttMs = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc)
+        {
+            jitterMs = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
         {
-            // Keeps the paddle at the top of the screen
-            position.y = 0;
+            profilePath = argv[++i];
         }
-        else if (position.y > (HEIGHT - Paddle_Height))
+        else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
         {
-            // Keeps the paddle at the bottom of the screen
-            position.y = HEIGHT - Paddle_Height;
+            ++i;
+            if (strcmp(argv[i], "vsync") == 0)
+            {
+                pacing = PacingMode::VSync;
+            }
+            else if (strcmp(argv[i], "fps") == 0)
+            {
+                pacing = PacingMode::TargetFps;
+            }
+            else if (strcmp(argv[i], "adaptive") == 0)
+            {
+                pacing = PacingMode::AdaptiveVSync;
+            }
+            else if (strcmp(argv[i], "off") == 0)
+            {
+                pacing = PacingMode::Unlimited;
+            }
         }
     }
-
-    Vec2 position;
-    Vec2 velocity;
-    SDL_Rect rect;
-};
-
-class PlayerScores
-{
-public:
-    PlayerScores(Vec2 position, SDL_Renderer *renderer, TTF_Font *font)
-        : renderer(renderer), font(font)
+    if (tickRate <= 0)
     {
-        surface = TTF_RenderText_Solid(font, "0", {0xFF, 0xFF, 0});
-        texture = SDL_CreateTextureFromSurface(renderer, surface);
-
-        int width, height;
-        SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
-
-        rect.x = static_cast<int>(position.x);
-        rect.y = static_cast<int>(position.y);
-        rect.w = width;
-        rect.h = height;
+        tickRate = Tick_Rate;
     }
 
-    void SetScore(int score)
+    // Replays only know about normal local matches, and netplay only
+    // about the one ball
+    const bool netplay = (hostPort > 0 && hostPort < 65535) || (joinPort > 0 && joinPort < 65535);
+    if (netplay)
     {
-        SDL_FreeSurface (surface);
-        SDL_DestroyTexture (texture);
-
-        surface = TTF_RenderText_Solid(font, to_string(score).c_str(), {0xFF, 0xFF, 0, 0xFF});
-        
-        texture = SDL_CreateTextureFromSurface(renderer, surface);
-
-        int height, width;
-        SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
-        rect.w = width;
-        rect.h = height;
+        ballCount = 1;
     }
-
-    ~PlayerScores()
+    const bool multiball = ballCount > 1;
+    if (multiball || netplay)
     {
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        recordPath = nullptr;
+        replayPath = nullptr;
     }
 
-    void Draw()
+    // A replay brings its own seed and tick rate
+    Replay replay;
+    if (replayPath != nullptr)
     {
-        SDL_RenderCopy(renderer, texture, nullptr, &rect);
+        if (!LoadReplay(replayPath, replay) || replay.tickRate == 0)
+        {
+            return 1;
+        }
+        seed = replay.seed;
+        tickRate = replay.tickRate;
     }
+    ReplayPlayer replayPlayer(replay);
+    ReplayRecorder recorder(seed, tickRate);
 
-    SDL_Renderer *renderer;
-    TTF_Font *font;
-    SDL_Rect rect{};
-    SDL_Texture *texture{};
-    SDL_Surface *surface{};
-};
-
-// Ball and Paddle Collision
-Contact chekcPaddleCollision(Ball const &ball, Paddle const &paddle)
-{
-    float ballLeft = ball.position.x;
-    float ballRight = ball.position.x + Ball_Width;
-    float ballTop = ball.position.y;
-    float ballBottom = ball.position.y + Ball_Height;
-
-    float paddleLeft = paddle.position.x;
-    float paddleRight = paddle.position.x + Paddle_Width;
-    float paddleTop = paddle.position.y;
-    float paddleBottom = paddle.position.y + Paddle_Height;
-
-    Contact contact{};
-
-    if (ballLeft >= paddleRight)
-    {
-        return contact;
-    }
-    if (ballRight <= paddleLeft)
-    {
-        return contact;
-    }
+    SDL_Init(SDL_INIT_EVERYTHING);
+    TTF_Init();
 
-    if (ballTop >= paddleBottom)
-    {
-        return contact;
-    }
-    if (ballBottom <= paddleTop)
+    SDL_Window *window = SDL_CreateWindow(
+        "Pong",
+        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+        WIDTH, HEIGHT,
+        SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
+    if (window == NULL)
     {
-        return contact;
+        cout << "SDL Window Creation Failed." << SDL_GetError() << '\n';
+        return 1;
     }
 
-    float paddleRangeUpper = paddleBottom - (2.0f * Paddle_Height / 3.0f);
-    float paddleRangerMiddle = paddleBottom - (Paddle_Height / 3.0f);
-
-    if (ball.velocity.x < 0)
-    {
-        // Left paddle
-        contact.penetration = paddleRight - ballLeft;
-    }
-    else if (ball.velocity.x > 0)
+    // The display's refresh rate, for the vsync modes and as the default
+    // frame rate
+    SDL_DisplayMode displayMode{};
+    double refreshRate = 60.0;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &displayMode) == 0 && displayMode.refresh_rate > 0)
     {
-        // Right paddle
-        contact.penetration = paddleLeft - ballRight;
+        refreshRate = displayMode.refresh_rate;
     }
 
-    if ((ballBottom > paddleTop) && (ballBottom < paddleRangeUpper))
+    // The software path has no vsync to wait on, so it paces on the CPU
+    if (software && (pacing == PacingMode::VSync || pacing == PacingMode::AdaptiveVSync))
     {
-        contact.type = CollisionType::Top;
+        pacing = PacingMode::TargetFps;
     }
-    else if ((ballBottom > paddleRangeUpper) && (ballBottom < paddleRangerMiddle))
+    if (targetFps <= 0.0 || pacing != PacingMode::TargetFps)
     {
-        contact.type = CollisionType::Middle;
+        targetFps = refreshRate;
     }
-    else
+    FramePacer pacer(pacing, targetFps);
+    bool vsyncOn = pacer.WantVSync();
+
+    // A window has either a renderer or a surface, not both
+    SDL_Renderer *renderer = software ? nullptr : SDL_CreateRenderer(window, -1, vsyncOn ? SDL_RENDERER_PRESENTVSYNC : 0);
+    Framebuffer offscreen(WIDTH, HEIGHT);
+
+    // Software path: this frame and the last, so only what changed is
+    // redrawn and presented
+    Scene scene;
+    Scene drawnScene;
+    DamageList damage(WIDTH, HEIGHT);
+    vector<SDL_Rect> damageRects;
+    bool redrawAll = true;
+
+    // Renderer path: everything goes through the draw list
+    DrawList drawList;
+    const SDL_Color yellow{0xFF, 0xFF, 0, 0xFF};
+    vector<SDL_Point> centerLine;
+    for (int i = 0; i < HEIGHT; i++)
     {
-        contact.type = CollisionType::Bottom;
+        if (i % 5 != 0)
+        {
+            centerLine.push_back({WIDTH / 2, i});
+        }
     }
 
-    return contact;
-}
-
-Contact CheckWallCollisions(Ball const &ball)
-{
-    float ballLeft = ball.position.x;
-    float ballRight = ball.position.x + Ball_Width;
-    float ballTop = ball.position.y;
-    float ballBottom = ball.position.y + Ball_Height;
-
-    Contact contact{};
-
-    if (ballLeft < 0.0f)
+    // Background and border never change, so they're drawn once into a
+    // texture
+    CachedLayer background(renderer, [&](SDL_Renderer *target)
     {
-        contact.type = CollisionType::Left;
-    }
-    else if (ballRight > WIDTH)
-    {
-        contact.type = CollisionType::Right;
-    }
-    else if (ballTop < 0.0f)
-    {
-        contact.type = CollisionType::Top;
-        contact.penetration = -ballTop;
-    }
-    else if (ballBottom > HEIGHT)
-    {
-        contact.type = CollisionType::Bottom;
-        contact.penetration = HEIGHT - ballBottom;
-    }
+        SDL_SetRenderDrawColor(target, 0xFF, 0x80, 0xFF, 0xFF);
+        SDL_RenderClear(target);
+        SDL_SetRenderDrawColor(target, 0xFF, 0xFF, 0, 0xFF);
+        SDL_RenderDrawPoints(target, centerLine.data(), static_cast<int>(centerLine.size()));
+    });
 
-    return contact;
-}
+    // Initialize the Text
+    TTF_Font *scoreFont = TTF_OpenFont("S:/Graphics-Development/Game_NumberFont.ttf", 40);
 
-int main(int argc, char *argv[])
-{
-    SDL_Init(SDL_INIT_EVERYTHING);
-    TTF_Init();
+    // Ball, paddles and score
+    Match match(seed);
 
-    SDL_Window *window = SDL_CreateWindow(
-        "Pong",
-        SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-        WIDTH, HEIGHT,
-        SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
-    if (window == NULL)
+    Arena arena(seed);
+    vector<SDL_Rect> sceneRects; // Balls and paddles this frame
+    if (multiball)
     {
-        cout << "SDL Window Creation Failed." << SDL_GetError() << '\n';
-        return 1;
+        arena.AddStandardPaddles();
+        arena.ServeBalls(ballCount);
     }
 
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, 0);
-
-    // Initialize the Text
-    TTF_Font *scoreFont = TTF_OpenFont("S:/Graphics-Development/Game_NumberFont.ttf", 40);
-
-    // Create Ball
-    Ball ball(
-        Vec2(WIDTH / 2.0f - Ball_Width / 2.0f, HEIGHT / 2.0f - Ball_Height / 2.0f),
-        Vec2(Ball_Speed, 0.0f));
-
-    // Create two Paddle
-    Paddle paddle1(
-        Vec2(50.0f, HEIGHT / 2.0f),
-        Vec2(0.0f, 0.0f));
+    // Player score text, every digit rasterized and uploaded once
+    GlyphAtlas scoreGlyphs(scoreFont, renderer, {0xFF, 0xFF, 0, 0xFF});
 
-    Paddle paddle2(
-        Vec2(WIDTH - 50.0f, HEIGHT / 2.0f),
-        Vec2(0.0f, 0.0f));
+    PlayerScores playerone(Vec2(WIDTH / 4.0f, 20.0f), scoreGlyphs);
 
-    // Player score text
-    PlayerScores playerone(Vec2(WIDTH / 4.0f, 20.0f), renderer, scoreFont);
+    PlayerScores playertwo(Vec2(WIDTH * 3 / 4, 20.0f), scoreGlyphs);
 
-    PlayerScores playertwo(Vec2(WIDTH * 3 / 4, 20.0f), renderer, scoreFont);
+    // Netplay: the session owns the match, both keyboard layouts drive
+    // our paddle and the other side's comes in over UDP
+    UdpSocket socket;
+    unique_ptr<RollbackSession> session;
+    unique_ptr<LaggyLink> link;
+    if (netplay)
+    {
+        int localPlayer = hostPort > 0 ? 0 : 1;
+        int localPort = hostPort > 0 ? hostPort : joinPort + 1;
+        int remotePort = hostPort > 0 ? hostPort + 1 : joinPort;
+        if (!socket.Open(static_cast<uint16_t>(localPort)))
+        {
+            return 1;
+        }
+        session = make_unique<RollbackSession>(localPlayer, seed, 1000.0f / tickRate);
+        link = make_unique<LaggyLink>(socket, static_cast<uint16_t>(remotePort), rttMs, jitterMs, seed);
+        cout << "Netplay as player " << localPlayer + 1 << " on port " << localPort << '\n';
+    }
+    auto startTime = chrono::high_resolution_clock::now();
+    long long stalledTicks = 0;
+    int shownScores[2] = {}; // What the score text says, as rollbacks can change it
 
     // GAME LOGIC
     bool running = true;
     bool buttons[4] = {};
 
-    int playerOneScore = 0;
-    int playerTwoScore = 0;
+    // Every tick advances the simulation by the same amount (in milliseconds)
+    const float tickDt = 1000.0f / tickRate;
+    float accumulator = 0.0f;
 
-    float dt = 0.0f;
+    auto previousTime = chrono::high_resolution_clock::now();
 
     while (running)
     {
-        auto startTime = chrono::high_resolution_clock::now();
+        // Everything but the pacer's wait
+        PROFILE_START(frameTimer, Phase_Frame);
+
+        // Bank the real time that passed since last frame
+        auto currentTime = chrono::high_resolution_clock::now();
+        accumulator += chrono::duration<float, chrono::milliseconds::period>(currentTime - previousTime).count();
+        previousTime = currentTime;
+
+        if (accumulator > Max_Ticks_Per_Frame * tickDt)
+        {
+            // Drop time we can't catch up on instead of spiralling
+            accumulator = Max_Ticks_Per_Frame * tickDt;
+        }
 
         // AN EVENT TO KEEP THE LOOP RUNNING
+        PROFILE_START(eventTimer, Phase_Events);
         SDL_Event event;
         while (SDL_PollEvent(&event))
         {
+            background.HandleEvent(event);
+
             if (event.type == SDL_QUIT)
             {
                 running = false;
             }
+            else if (event.type == SDL_WINDOWEVENT)
+            {
+                // The surface may be new or its contents gone
+                redrawAll = true;
+            }
             else if (event.type == SDL_KEYDOWN)
             {
                 if (event.key.keysym.sym == SDLK_ESCAPE)
@@ -440,105 +447,275 @@ int main(int argc, char *argv[])
                 }
             }
         }
+        PROFILE_STOP(eventTimer);
 
-        if (buttons[Buttons::PaddleOneUP])
+        if (session)
         {
-            paddle1.velocity.y = -Paddle_Speed;
-        }
-        else if (buttons[Buttons::PaddleOneDown])
-        {
-            paddle1.velocity.y = Paddle_Speed;
-        }
-        else
-        {
-            paddle1.velocity.y = 0.0f;
+            uint8_t packet[Rollback_Packet_Size];
+            for (int size; (size = socket.Receive(packet, sizeof(packet))) >= 0;)
+            {
+                session->ReadPacket(packet, size);
+            }
         }
 
-        if (buttons[Buttons::PaddleTwoUp])
+        // Run as many fixed ticks as the banked time covers
+        while (accumulator >= tickDt)
         {
-            paddle2.velocity.y = -Paddle_Speed;
-        }
-        else if (buttons[Buttons::PaddleTwoDown])
-        {
-            paddle2.velocity.y = Paddle_Speed;
+            PROFILE_START(inputTimer, Phase_Input);
+            uint8_t held = PackButtons(buttons);
+            if (replayPath != nullptr && !replayPlayer.Next(held))
+            {
+                // Replay's over, hand the paddles back to the keyboard
+                replayPath = nullptr;
+                held = PackButtons(buttons);
+            }
+
+            if (recordPath != nullptr)
+            {
+                recorder.Record(held, match);
+            }
+
+            bool tickButtons[4];
+            UnpackButtons(held, tickButtons);
+            PROFILE_STOP(inputTimer);
+
+            if (session)
+            {
+                // Too far ahead of the other side: keep the time banked
+                // and wait for its inputs
+                if (!session->CanAdvance())
+                {
+                    ++stalledTicks;
+                    break;
+                }
+
+                bool up = tickButtons[Buttons::PaddleOneUP] || tickButtons[Buttons::PaddleTwoUp];
+                bool down = tickButtons[Buttons::PaddleOneDown] || tickButtons[Buttons::PaddleTwoDown];
+                session->AdvanceFrame(static_cast<uint8_t>(up | (down << 1)));
+
+                // A rollback can take a goal back, so compare rather than
+                // wait for Tick's result
+                Match const &current = session->CurrentMatch();
+                if (current.playerOneScore != shownScores[0])
+                {
+                    shownScores[0] = current.playerOneScore;
+                    playerone.SetScore(current.playerOneScore);
+                }
+                if (current.playerTwoScore != shownScores[1])
+                {
+                    shownScores[1] = current.playerTwoScore;
+                    playertwo.SetScore(current.playerTwoScore);
+                }
+            }
+            else if (multiball)
+            {
+                int playerOneBefore = arena.playerOneScore;
+                int playerTwoBefore = arena.playerTwoScore;
+
+                arena.SetButtons(tickButtons);
+                arena.Step(tickDt);
+
+                if (arena.playerOneScore != playerOneBefore)
+                {
+                    playerone.SetScore(arena.playerOneScore);
+                }
+                if (arena.playerTwoScore != playerTwoBefore)
+                {
+                    playertwo.SetScore(arena.playerTwoScore);
+                }
+            }
+            else
+            {
+                match.SetButtons(tickButtons);
+
+                CollisionType scored = match.Tick(tickDt);
+
+                if (scored == CollisionType::Left)
+                {
+                    playertwo.SetScore(match.playerTwoScore);
+                }
+                else if (scored == CollisionType::Right)
+                {
+                    playerone.SetScore(match.playerOneScore);
+                }
+            }
+
+            accumulator -= tickDt;
         }
-        else
+
+        if (session)
         {
-            paddle2.velocity.y = 0.0f;
+            double nowMs = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - startTime).count();
+            uint8_t packet[Rollback_Packet_Size];
+            size_t size = session->BuildPacket(packet, sizeof(packet));
+            link->Send(nowMs, packet, size);
+            link->Flush(nowMs);
         }
 
-        // Update paddle position
-        paddle1.update(dt);
-        paddle2.update(dt);
+        // How far we are between the last tick and the next one
+        float alpha = accumulator / tickDt;
+        Match const &shown = session ? session->CurrentMatch() : match;
 
-        // Update Ball position
-        ball.update(dt);
-
-        // Check collisions
-        if (Contact contact = chekcPaddleCollision(ball, paddle1);
-            contact.type != CollisionType::None)
+        // Everything with a box, balls and paddles alike
+        sceneRects.clear();
+        if (multiball)
         {
-            ball.CollisionWithPaddle(contact);
+            arena.entities.ForEach(Component_Position | Component_Extents, [&](Archetype const &archetype)
+            {
+                for (int i = 0; i < archetype.Size(); i++)
+                {
+                    float x = archetype.previousX[i] + (archetype.x[i] - archetype.previousX[i]) * alpha;
+                    float y = archetype.previousY[i] + (archetype.y[i] - archetype.previousY[i]) * alpha;
+                    sceneRects.push_back({static_cast<int>(x), static_cast<int>(y),
+                                          static_cast<int>(archetype.width[i]), static_cast<int>(archetype.height[i])});
+                }
+            });
         }
-        else if (contact = chekcPaddleCollision(ball, paddle2);
-                 contact.type != CollisionType::None)
+        else
         {
-            ball.CollisionWithPaddle(contact);
+            sceneRects.push_back(BallRect(shown.ball, alpha));
+            sceneRects.push_back(PaddleRect(shown.paddle1, alpha));
+            sceneRects.push_back(PaddleRect(shown.paddle2, alpha));
         }
-        else if (contact = CheckWallCollisions(ball);
-                 contact.type != CollisionType::None)
+
+        if (software)
         {
-            ball.CollideWithWall(contact);
+            PROFILE_START(drawTimer, Phase_Draw);
+            SDL_Surface *surface = SDL_GetWindowSurface(window);
+            if (surface == nullptr)
+            {
+                cout << "No window surface: " << SDL_GetError() << '\n';
+                break;
+            }
 
-            if (contact.type == CollisionType::Left)
+            scene.boxes.clear();
+            for (SDL_Rect const &rect : sceneRects)
             {
-                ++playerTwoScore;
+                scene.boxes.push_back({rect.x, rect.y, rect.w, rect.h});
+            }
+            scene.glyphs.clear();
+            playerone.AddGlyphs(scene.glyphs);
+            playertwo.AddGlyphs(scene.glyphs);
 
-                playertwo.SetScore(playerTwoScore);
+            damage.Clear();
+            if (redrawAll)
+            {
+                damage.AddAll();
+                redrawAll = false;
             }
-            else if (contact.type == CollisionType::Right)
+            else
             {
-                ++playerOneScore;
-                playerone.SetScore(playerOneScore);
+                damage.AddChanges(drawnScene, scene);
             }
-        }
+            swap(drawnScene, scene);
 
-        SDL_SetRenderDrawColor(renderer, 0xFF, 0x80, 0xFF, 0xFF);
-        SDL_RenderClear(renderer);
+            // Nothing changed, nothing to present
+            if (!damage.Rects().empty())
+            {
+                SDL_LockSurface(surface);
+                Framebuffer target = SoftwareTarget(surface, offscreen);
 
-        // Set the color to yellow;
-        SDL_SetRenderDrawColor(renderer, 0xFF, 0xFF, 0, 0xFF);
+                damageRects.clear();
+                for (Rect const &rect : damage.Rects())
+                {
+                    target.SetClip(rect);
+                    DrawScene(target, drawnScene);
+
+                    Rect clip = target.Clip();
+                    if (target.Pixels() == offscreen.Pixels() && !IsEmpty(clip))
+                    {
+                        int bytesPerPixel = surface->format->BytesPerPixel;
+                        SDL_ConvertPixels(clip.w, clip.h,
+                                          SDL_PIXELFORMAT_ARGB8888, offscreen.Row(clip.y) + clip.x, offscreen.Pitch(),
+                                          surface->format->format,
+                                          static_cast<uint8_t *>(surface->pixels) + clip.y * surface->pitch + clip.x * bytesPerPixel,
+                                          surface->pitch);
+                    }
+                    damageRects.push_back({clip.x, clip.y, clip.w, clip.h});
+                }
 
-        // Draw border
-        for (int i = 0; i < HEIGHT; i++)
-        {
-            if (i % 5 != 0)
-            {
-                SDL_RenderDrawPoint(renderer, WIDTH / 2, i);
+                SDL_UnlockSurface(surface);
+                PROFILE_STOP(drawTimer);
+
+                PROFILE_SCOPE(Phase_Present);
+                SDL_UpdateWindowSurfaceRects(window, damageRects.data(), static_cast<int>(damageRects.size()));
             }
         }
+        else
+        {
+            // The cached background stands in for a clear; repainting it
+            // when the texture is lost counts here, copying it under Draw
+            PROFILE_START(clearTimer, Phase_Clear);
+            drawList.Clear();
+
+            // Background and border, covering the whole screen so no clear
+            background.Draw(drawList);
+            PROFILE_STOP(clearTimer);
+
+            PROFILE_START(drawTimer, Phase_Draw);
+
+            // Draw Ball and Paddles
+            drawList.SetLayer(1);
+            drawList.FillRects(sceneRects.data(), static_cast<int>(sceneRects.size()), yellow);
+
+            // Draw Scores, on top
+            drawList.SetLayer(2);
+            playerone.Draw(drawList);
+            playertwo.Draw(drawList);
+
+            drawList.Submit(renderer);
+            PROFILE_STOP(drawTimer);
+
+            // Present the backbuffer
+            PROFILE_SCOPE(Phase_Present);
+            SDL_RenderPresent(renderer);
+        }
 
-        // Draw Ball
-        ball.Draw(renderer);
+        PROFILE_STOP(frameTimer);
 
-        // Draw Paddles
-        paddle1.Draw(renderer);
-        paddle2.Draw(renderer);
+        // Wait out the rest of the frame; adaptive vsync may also turn
+        // vsync on or off here
+        pacer.EndFrame();
+        if (renderer != nullptr && pacer.WantVSync() != vsyncOn)
+        {
+            vsyncOn = pacer.WantVSync();
+            SDL_RenderSetVSync(renderer, vsyncOn ? 1 : 0);
+        }
+    }
 
-        // Draw Scores
-        playerone.Draw();
-        playertwo.Draw();
+    if (recordPath != nullptr)
+    {
+        SaveReplay(recordPath, recorder.Finish());
+    }
 
-        // Present the backbuffer
-        SDL_RenderPresent(renderer);
+    pacer.Report(cout);
 
-        // Calculate frame time
-        auto stopTime = chrono::high_resolution_clock::now();
-        dt = chrono::duration<float, chrono::milliseconds::period>(stopTime - startTime).count();
+    if (session)
+    {
+        cout << "netplay:        frame " << session->Frame() << ", " << stalledTicks << " stalled, "
+             << session->rollbacks << " rollbacks (longest " << session->longestRollback << " frames)\n";
+    }
+
+    if (Profiling)
+    {
+        PrintProfile(cout);
+        if (profilePath != nullptr)
+        {
+            WriteProfile(profilePath);
+        }
+    }
+    else if (profilePath != nullptr)
+    {
+        cout << "Built without PONG_PROFILE, no timings to save (make PROFILE=1)\n";
     }
 
     // CLEANUPS ALWAYS!!!!!!!!!!
-    SDL_DestroyRenderer(renderer);
+    background.Release();
+    scoreGlyphs.Release();
+    if (renderer != nullptr)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
     SDL_DestroyWindow(window);
     TTF_CloseFont(scoreFont);
     TTF_Quit();
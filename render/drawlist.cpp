@@ -0,0 +1,200 @@
+#include "drawlist.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Key layout: layer in the top 16 bits, kind in the next 8, state below
+static const int Layer_Shift = 48;
+static const int Kind_Shift = 40;
+
+void DrawList::Clear()
+{
+    layer = 0;
+    commands.clear();
+    rects.clear();
+    points.clear();
+    quads.clear();
+    colors.clear();
+    textures.clear();
+}
+
+void DrawList::SetLayer(int newLayer)
+{
+    layer = newLayer;
+}
+
+uint64_t DrawList::Key(Kind kind, int state) const
+{
+    return (static_cast<uint64_t>(layer & 0xFFFF) << Layer_Shift) |
+           (static_cast<uint64_t>(kind) << Kind_Shift) |
+           static_cast<uint64_t>(state);
+}
+
+int DrawList::ColorState(SDL_Color color)
+{
+    for (size_t i = 0; i < colors.size(); i++)
+    {
+        if (colors[i].r == color.r && colors[i].g == color.g && colors[i].b == color.b && colors[i].a == color.a)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    colors.push_back(color);
+    return static_cast<int>(colors.size() - 1);
+}
+
+int DrawList::TextureState(SDL_Texture *texture)
+{
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        if (textures[i] == texture)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    textures.push_back(texture);
+    return static_cast<int>(textures.size() - 1);
+}
+
+void DrawList::FillRect(SDL_Rect const &rect, SDL_Color color)
+{
+    FillRects(&rect, 1, color);
+}
+
+void DrawList::FillRects(SDL_Rect const *newRects, int count, SDL_Color color)
+{
+    uint64_t key = Key(Kind_Rects, ColorState(color));
+    for (int i = 0; i < count; i++)
+    {
+        commands.push_back({key, static_cast<int>(rects.size())});
+        rects.push_back(newRects[i]);
+    }
+}
+
+void DrawList::DrawPoints(SDL_Point const *newPoints, int count, SDL_Color color)
+{
+    uint64_t key = Key(Kind_Points, ColorState(color));
+    for (int i = 0; i < count; i++)
+    {
+        commands.push_back({key, static_cast<int>(points.size())});
+        points.push_back(newPoints[i]);
+    }
+}
+
+void DrawList::DrawTexture(SDL_Texture *texture, SDL_Rect const *source, SDL_Rect const &destination)
+{
+    if (texture == nullptr)
+    {
+        return;
+    }
+
+    commands.push_back({Key(Kind_Textured, TextureState(texture)), static_cast<int>(quads.size())});
+    quads.push_back({source != nullptr ? *source : SDL_Rect{}, destination});
+}
+
+void DrawList::Submit(SDL_Renderer *renderer)
+{
+    drawCalls = 0;
+
+    // Ties go by index, which grows as primitives of a kind are added, so
+    // ones sharing a state keep their order without stable_sort's buffer
+    sort(commands.begin(), commands.end(), [](Command const &a, Command const &b) {
+        return a.key != b.key ? a.key < b.key : a.index < b.index;
+    });
+
+    size_t begin = 0;
+    while (begin < commands.size())
+    {
+        size_t end = begin + 1;
+        while (end < commands.size() && commands[end].key == commands[begin].key)
+        {
+            end++;
+        }
+
+        Kind kind = static_cast<Kind>((commands[begin].key >> Kind_Shift) & 0xFF);
+        if (kind == Kind_Rects)
+        {
+            SubmitRects(renderer, begin, end);
+        }
+        else if (kind == Kind_Points)
+        {
+            SubmitPoints(renderer, begin, end);
+        }
+        else
+        {
+            SubmitQuads(renderer, begin, end);
+        }
+        drawCalls++;
+
+        begin = end;
+    }
+}
+
+void DrawList::SubmitRects(SDL_Renderer *renderer, size_t begin, size_t end)
+{
+    SDL_Color color = colors[commands[begin].key & 0xFFFFFFFF];
+
+    rectBatch.clear();
+    for (size_t i = begin; i < end; i++)
+    {
+        rectBatch.push_back(rects[commands[i].index]);
+    }
+
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderFillRects(renderer, rectBatch.data(), static_cast<int>(rectBatch.size()));
+}
+
+void DrawList::SubmitPoints(SDL_Renderer *renderer, size_t begin, size_t end)
+{
+    SDL_Color color = colors[commands[begin].key & 0xFFFFFFFF];
+
+    pointBatch.clear();
+    for (size_t i = begin; i < end; i++)
+    {
+        pointBatch.push_back(points[commands[i].index]);
+    }
+
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    SDL_RenderDrawPoints(renderer, pointBatch.data(), static_cast<int>(pointBatch.size()));
+}
+
+void DrawList::SubmitQuads(SDL_Renderer *renderer, size_t begin, size_t end)
+{
+    SDL_Texture *texture = textures[commands[begin].key & 0xFFFFFFFF];
+
+    int width = 1;
+    int height = 1;
+    SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
+
+    // Two triangles per quad, all of them in one call
+    const SDL_Color white{0xFF, 0xFF, 0xFF, 0xFF};
+    vertices.clear();
+    indices.clear();
+    for (size_t i = begin; i < end; i++)
+    {
+        Quad const &quad = quads[commands[i].index];
+        SDL_Rect source = quad.source.w != 0 ? quad.source : SDL_Rect{0, 0, width, height};
+        SDL_Rect const &d = quad.destination;
+
+        float u0 = static_cast<float>(source.x) / width;
+        float v0 = static_cast<float>(source.y) / height;
+        float u1 = static_cast<float>(source.x + source.w) / width;
+        float v1 = static_cast<float>(source.y + source.h) / height;
+
+        int first = static_cast<int>(vertices.size());
+        vertices.push_back({{static_cast<float>(d.x), static_cast<float>(d.y)}, white, {u0, v0}});
+        vertices.push_back({{static_cast<float>(d.x + d.w), static_cast<float>(d.y)}, white, {u1, v0}});
+        vertices.push_back({{static_cast<float>(d.x + d.w), static_cast<float>(d.y + d.h)}, white, {u1, v1}});
+        vertices.push_back({{static_cast<float>(d.x), static_cast<float>(d.y + d.h)}, white, {u0, v1}});
+
+        int corners[6] = {0, 1, 2, 0, 2, 3};
+        for (int corner : corners)
+        {
+            indices.push_back(first + corner);
+        }
+    }
+
+    SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+}
@@ -0,0 +1,88 @@
+// Per-frame draw list for the SDL renderer.
+//
+// Drawing code adds rects, points and textured quads as it goes; Submit
+// then sorts them by layer and state (color or texture) and hands each run
+// to SDL in one call: SDL_RenderFillRects, SDL_RenderDrawPoints or
+// SDL_RenderGeometry. The number of calls depends on how many colors and
+// textures a frame uses, not on how many things are on screen.
+//
+// Within a layer the order is free, so only put things that must stay
+// on top of each other in different layers. Everything is kept between
+// frames, so once the buffers have grown a frame allocates nothing.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+
+class DrawList
+{
+public:
+    // Drop last frame's commands (the memory stays)
+    void Clear();
+
+    // Later layers are drawn over earlier ones; starts at 0
+    void SetLayer(int layer);
+
+    void FillRect(SDL_Rect const &rect, SDL_Color color);
+    void FillRects(SDL_Rect const *rects, int count, SDL_Color color);
+    void DrawPoints(SDL_Point const *points, int count, SDL_Color color);
+
+    // source may be null for the whole texture
+    void DrawTexture(SDL_Texture *texture, SDL_Rect const *source, SDL_Rect const &destination);
+
+    void Submit(SDL_Renderer *renderer);
+
+    // SDL draw calls made by the last Submit, and things drawn by them
+    int DrawCalls() const { return drawCalls; }
+    int Primitives() const { return static_cast<int>(commands.size()); }
+
+private:
+    enum Kind : uint8_t
+    {
+        Kind_Rects,
+        Kind_Points,
+        Kind_Textured,
+    };
+
+    struct Quad
+    {
+        SDL_Rect source; // w == 0 for the whole texture
+        SDL_Rect destination;
+    };
+
+    // Sorts by layer, then kind, then state; index says where in rects,
+    // points or quads the primitive is
+    struct Command
+    {
+        uint64_t key;
+        int index;
+    };
+
+    uint64_t Key(Kind kind, int state) const;
+    int ColorState(SDL_Color color);
+    int TextureState(SDL_Texture *texture);
+
+    void SubmitRects(SDL_Renderer *renderer, size_t begin, size_t end);
+    void SubmitPoints(SDL_Renderer *renderer, size_t begin, size_t end);
+    void SubmitQuads(SDL_Renderer *renderer, size_t begin, size_t end);
+
+    int layer = 0;
+    int drawCalls = 0;
+
+    std::vector<Command> commands;
+    std::vector<SDL_Rect> rects;
+    std::vector<SDL_Point> points;
+    std::vector<Quad> quads;
+
+    // The distinct colors and textures this frame; a handful, so found by
+    // walking the list
+    std::vector<SDL_Color> colors;
+    std::vector<SDL_Texture *> textures;
+
+    // Runs gathered here before they go to SDL
+    std::vector<SDL_Rect> rectBatch;
+    std::vector<SDL_Point> pointBatch;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+};
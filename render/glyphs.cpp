@@ -0,0 +1,183 @@
+#include "glyphs.h"
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+GlyphAtlas::GlyphAtlas(TTF_Font *font, SDL_Renderer *renderer, SDL_Color color, char const *characters)
+{
+    memset(slots, -1, sizeof(slots));
+    if (font == nullptr)
+    {
+        return;
+    }
+
+    height = TTF_FontHeight(font);
+
+    // Rasterize every glyph, then pack them side by side with a pixel of
+    // space so sampling one never picks up its neighbour
+    vector<SDL_Surface *> surfaces;
+    vector<char> packed;
+    for (char const *c = characters; *c != '\0'; c++)
+    {
+        unsigned char ch = static_cast<unsigned char>(*c);
+        if (ch >= 128 || slots[ch] >= 0)
+        {
+            continue;
+        }
+
+        SDL_Surface *surface = TTF_RenderGlyph_Solid(font, ch, color);
+        if (surface == nullptr)
+        {
+            continue;
+        }
+
+        int advance = 0;
+        TTF_GlyphMetrics(font, ch, nullptr, nullptr, nullptr, nullptr, &advance);
+
+        entries[ch].rect = {atlasWidth, 0, surface->w, surface->h};
+        entries[ch].advance = advance;
+        slots[ch] = static_cast<int8_t>(slotCount++);
+        atlasWidth += surface->w + 1;
+        height = surface->h > height ? surface->h : height;
+
+        surfaces.push_back(surface);
+        packed.push_back(static_cast<char>(ch));
+    }
+
+    kerning.assign(static_cast<size_t>(slotCount) * slotCount, 0);
+    for (char previous : packed)
+    {
+        for (char next : packed)
+        {
+            kerning[slots[static_cast<int>(previous)] * slotCount + slots[static_cast<int>(next)]] =
+                static_cast<int8_t>(TTF_GetFontKerningSizeGlyphs(font, previous, next));
+        }
+    }
+
+    // Solid glyph surfaces are 8-bit with index 0 as the background
+    mask.assign(static_cast<size_t>(atlasWidth) * height, 0);
+    for (size_t i = 0; i < surfaces.size(); i++)
+    {
+        SDL_Surface *surface = surfaces[i];
+        SDL_Rect const &rect = entries[static_cast<int>(packed[i])].rect;
+
+        SDL_LockSurface(surface);
+        for (int y = 0; y < surface->h; y++)
+        {
+            uint8_t const *row = static_cast<uint8_t const *>(surface->pixels) + y * surface->pitch;
+            for (int x = 0; x < surface->w; x++)
+            {
+                mask[static_cast<size_t>(y) * atlasWidth + rect.x + x] = row[x] != 0;
+            }
+        }
+        SDL_UnlockSurface(surface);
+        SDL_FreeSurface(surface);
+    }
+
+    if (renderer == nullptr || atlasWidth == 0)
+    {
+        return;
+    }
+
+    // The texture is the mask in color, transparent elsewhere; uploaded
+    // once and then only sampled from
+    SDL_Surface *pixels = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (pixels == nullptr)
+    {
+        cout << "Glyph atlas creation failed: " << SDL_GetError() << '\n';
+        return;
+    }
+
+    uint32_t lit = SDL_MapRGBA(pixels->format, color.r, color.g, color.b, 0xFF);
+    uint32_t clear = SDL_MapRGBA(pixels->format, color.r, color.g, color.b, 0);
+    SDL_LockSurface(pixels);
+    for (int y = 0; y < height; y++)
+    {
+        uint32_t *row = reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(pixels->pixels) + y * pixels->pitch);
+        for (int x = 0; x < atlasWidth; x++)
+        {
+            row[x] = mask[static_cast<size_t>(y) * atlasWidth + x] ? lit : clear;
+        }
+    }
+    SDL_UnlockSurface(pixels);
+
+    texture = SDL_CreateTextureFromSurface(renderer, pixels);
+    SDL_FreeSurface(pixels);
+    if (texture == nullptr)
+    {
+        cout << "Glyph atlas upload failed: " << SDL_GetError() << '\n';
+        return;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    Release();
+}
+
+void GlyphAtlas::Release()
+{
+    if (texture != nullptr)
+    {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+}
+
+template <typename Place>
+int GlyphAtlas::Layout(char const *text, int x, Place const &place) const
+{
+    int previous = -1;
+    for (char const *c = text; *c != '\0'; c++)
+    {
+        unsigned char ch = static_cast<unsigned char>(*c);
+        if (ch >= 128 || slots[ch] < 0)
+        {
+            continue;
+        }
+
+        if (previous >= 0)
+        {
+            x += kerning[previous * slotCount + slots[ch]];
+        }
+        place(entries[ch], x);
+
+        x += entries[ch].advance;
+        previous = slots[ch];
+    }
+    return x;
+}
+
+void GlyphAtlas::DrawText(DrawList &drawList, char const *text, int x, int y) const
+{
+    if (texture == nullptr)
+    {
+        return;
+    }
+
+    Layout(text, x, [&](Entry const &entry, int penX) {
+        drawList.DrawTexture(texture, &entry.rect, SDL_Rect{penX, y, entry.rect.w, entry.rect.h});
+    });
+}
+
+void GlyphAtlas::AddText(vector<Glyph> &glyphs, char const *text, int x, int y) const
+{
+    Layout(text, x, [&](Entry const &entry, int penX) {
+        Glyph glyph;
+        glyph.mask = mask.data() + entry.rect.x;
+        glyph.x = penX;
+        glyph.y = y;
+        glyph.width = entry.rect.w;
+        glyph.height = entry.rect.h;
+        glyph.pitch = atlasWidth;
+        glyphs.push_back(glyph);
+    });
+}
+
+int GlyphAtlas::TextWidth(char const *text) const
+{
+    return Layout(text, 0, [](Entry const &, int) {});
+}
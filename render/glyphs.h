@@ -0,0 +1,65 @@
+// Glyph atlas for HUD text (scores): every character rasterized once at
+// startup into one mask and one texture, so changing the text later costs
+// no TTF rendering, no allocation and no texture upload.
+//
+// Text is laid out one glyph at a time by advance, plus the font's
+// kerning for each pair (measured up front too). For the number font
+// that's what TTF_RenderText would have produced.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "../game/scene.h"
+#include "drawlist.h"
+
+// Digits plus what a score line or timer needs
+const char *const Hud_Characters = "0123456789 -:/";
+
+class GlyphAtlas
+{
+public:
+    // renderer may be null (software path): then only the mask is built.
+    // A null font gives an empty atlas that draws nothing.
+    GlyphAtlas(TTF_Font *font, SDL_Renderer *renderer, SDL_Color color, char const *characters = Hud_Characters);
+    ~GlyphAtlas();
+
+    GlyphAtlas(GlyphAtlas const &) = delete;
+    GlyphAtlas &operator=(GlyphAtlas const &) = delete;
+
+    // Characters not in the atlas are skipped
+    void DrawText(DrawList &drawList, char const *text, int x, int y) const;
+
+    // Same layout, as masks for the software path
+    void AddText(std::vector<Glyph> &glyphs, char const *text, int x, int y) const;
+
+    int TextWidth(char const *text) const;
+    int Height() const { return height; }
+
+    // Free the texture; has to happen before the renderer is destroyed
+    void Release();
+
+private:
+    struct Entry
+    {
+        SDL_Rect rect{}; // Where it is in the atlas
+        int advance = 0;
+    };
+
+    // Calls place(entry, penX) for every character of text that's in the
+    // atlas, returns where the pen ends up
+    template <typename Place>
+    int Layout(char const *text, int x, Place const &place) const;
+
+    Entry entries[128];
+    int8_t slots[128]; // Character -> index into kerning rows, -1 if absent
+    std::vector<int8_t> kerning; // slotCount * slotCount, previous then next
+    int slotCount = 0;
+
+    std::vector<uint8_t> mask; // 1 where a glyph is lit
+    int atlasWidth = 0;
+    int height = 0;
+    SDL_Texture *texture = nullptr;
+};
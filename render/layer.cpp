@@ -0,0 +1,98 @@
+#include "layer.h"
+
+#include <iostream>
+
+using namespace std;
+
+CachedLayer::CachedLayer(SDL_Renderer *renderer, Painter paint)
+    : renderer(renderer), paint(move(paint)), supported(SDL_RenderTargetSupported(renderer) == SDL_TRUE)
+{
+}
+
+CachedLayer::~CachedLayer()
+{
+    Release();
+}
+
+void CachedLayer::Release()
+{
+    if (texture != nullptr)
+    {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+}
+
+void CachedLayer::HandleEvent(SDL_Event const &event)
+{
+    if (event.type == SDL_RENDER_DEVICE_RESET)
+    {
+        // Every texture is gone, not just its contents
+        Release();
+        dirty = true;
+    }
+    else if (event.type == SDL_RENDER_TARGETS_RESET)
+    {
+        dirty = true;
+    }
+    else if (event.type == SDL_WINDOWEVENT &&
+             (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED || event.window.event == SDL_WINDOWEVENT_DISPLAY_CHANGED))
+    {
+        dirty = true;
+    }
+}
+
+bool CachedLayer::Rebuild(int newWidth, int newHeight)
+{
+    if (texture == nullptr || newWidth != width || newHeight != height)
+    {
+        Release();
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, newWidth, newHeight);
+        if (texture == nullptr)
+        {
+            cout << "Layer texture creation failed, drawing it every frame: " << SDL_GetError() << '\n';
+            supported = false;
+            return false;
+        }
+
+        // It covers everything, so there's nothing to blend with
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+        width = newWidth;
+        height = newHeight;
+    }
+
+    SDL_Texture *previousTarget = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, texture);
+    paint(renderer);
+    SDL_SetRenderTarget(renderer, previousTarget);
+
+    repaints++;
+    return true;
+}
+
+void CachedLayer::Draw(DrawList &drawList)
+{
+    if (!supported)
+    {
+        paint(renderer);
+        return;
+    }
+
+    // A DPI change can resize the output without any event we act on, and
+    // this costs next to nothing
+    int outputWidth = 0;
+    int outputHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &outputWidth, &outputHeight);
+
+    if (dirty || texture == nullptr || outputWidth != width || outputHeight != height)
+    {
+        if (!Rebuild(outputWidth, outputHeight))
+        {
+            paint(renderer);
+            return;
+        }
+        dirty = false;
+    }
+
+    drawList.DrawTexture(texture, nullptr, SDL_Rect{0, 0, width, height});
+}
@@ -0,0 +1,58 @@
+// Static content (the background and center line) rendered once into a
+// target texture and then drawn as one textured quad a frame.
+//
+// The texture is the size of the renderer's output, so it's rebuilt when
+// that changes (window resize, moving to a display with another DPI). It's
+// also rebuilt when SDL says target textures lost their contents, and
+// recreated outright after a device reset. Renderers without target
+// texture support just get the painter called every frame.
+#pragma once
+
+#include <functional>
+#include <SDL2/SDL.h>
+
+#include "drawlist.h"
+
+class CachedLayer
+{
+public:
+    // Draws the layer's content into whatever target is set, in the same
+    // coordinates as everything else
+    using Painter = std::function<void(SDL_Renderer *)>;
+
+    CachedLayer(SDL_Renderer *renderer, Painter paint);
+    ~CachedLayer();
+
+    CachedLayer(CachedLayer const &) = delete;
+    CachedLayer &operator=(CachedLayer const &) = delete;
+
+    // Pass every event through; the window and render-reset ones drop the
+    // cache
+    void HandleEvent(SDL_Event const &event);
+
+    // Repaint next frame, e.g. after changing what the painter draws
+    void Invalidate() { dirty = true; }
+
+    // Repaints the texture if needed and adds it to drawList as one quad.
+    // Without a texture this paints straight away, so call it before
+    // anything that goes on top.
+    void Draw(DrawList &drawList);
+
+    // Times the texture was (re)painted
+    int Repaints() const { return repaints; }
+
+    // Free the texture; has to happen before the renderer is destroyed
+    void Release();
+
+private:
+    bool Rebuild(int width, int height);
+
+    SDL_Renderer *renderer;
+    Painter paint;
+    SDL_Texture *texture = nullptr;
+    int width = 0;
+    int height = 0;
+    bool dirty = true;
+    bool supported;
+    int repaints = 0;
+};